@@ -50,6 +50,7 @@ struct MeshSettings
     static constexpr std::uint32_t FileADT = 'ADT\0';
     static constexpr std::uint32_t FileWMO = 'WMO\0';
     static constexpr std::uint32_t FileMap = 'MAP1';
+    static constexpr std::uint32_t FileOracle = 'ORCL';
     static constexpr std::uint32_t WMOcoordinate = 0xFFFFFFFF;
 
     // Nothing below here should ever have to change
@@ -205,5 +206,15 @@ enum class Result {
 
     FAILED_TO_FIND_POINT_BETWEEN_VECTORS = 89,
 
+    FAILED_TO_BUILD_FLOW_FIELD = 90,
+
+    NOT_ORACLE_FILE = 91,
+    PATH_ORACLE_SERIALIZATION_FAILED_TO_OPEN_OUTPUT_FILE = 92,
+    FAILED_TO_BUILD_PATH_ORACLE = 93,
+
+    FAILED_TO_MOVE_ALONG_SURFACE = 94,
+
+    FAILED_TO_MAP_FILE = 95,
+
     UNKNOWN_EXCEPTION = 0xFF,
 };
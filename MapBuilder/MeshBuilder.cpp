@@ -16,6 +16,7 @@
 #include "utility/Vector.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
@@ -27,6 +28,7 @@
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <system_error>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -451,6 +453,122 @@ bool IsHeightFieldEmpty(rcHeightfield const& solid)
 
     return true;
 }
+
+// merges vertices closer together than 'epsilon', and drops the faces which
+// are then degenerate or repeated.  the collision trees built from the result
+// are smaller and faster to trace, but not otherwise different
+void CleanCollisionMesh(std::vector<math::Vertex>& vertices,
+                        std::vector<int>& indices, float epsilon = 0.001f)
+{
+    using Cell = std::array<std::int64_t, 3>;
+
+    struct CellHash
+    {
+        std::size_t operator()(const Cell& cell) const
+        {
+            return static_cast<std::size_t>(cell[0] * 73856093ll ^
+                                            cell[1] * 19349663ll ^
+                                            cell[2] * 83492791ll);
+        }
+    };
+
+    auto const cellOf = [epsilon](const math::Vertex& v)
+    {
+        return Cell {static_cast<std::int64_t>(std::floor(v.X / epsilon)),
+                     static_cast<std::int64_t>(std::floor(v.Y / epsilon)),
+                     static_cast<std::int64_t>(std::floor(v.Z / epsilon))};
+    };
+
+    // the cells are 'epsilon' wide, so a vertex within 'epsilon' of another
+    // lies in the same cell or one of its neighbours
+    std::unordered_map<Cell, std::vector<int>, CellHash> cells;
+    std::vector<math::Vertex> welded;
+    std::vector<int> remap(vertices.size());
+
+    for (auto i = 0u; i < vertices.size(); ++i)
+    {
+        auto const& vertex = vertices[i];
+        auto const cell = cellOf(vertex);
+
+        auto match = -1;
+        for (auto n = 0; n < 27 && match < 0; ++n)
+        {
+            auto const neighbour =
+                cells.find({cell[0] + n % 3 - 1, cell[1] + n / 3 % 3 - 1,
+                            cell[2] + n / 9 - 1});
+
+            if (neighbour == cells.end())
+                continue;
+
+            for (auto const w : neighbour->second)
+                if (welded[w].GetDistance(vertex) <= epsilon)
+                {
+                    match = w;
+                    break;
+                }
+        }
+
+        if (match < 0)
+        {
+            match = static_cast<int>(welded.size());
+            welded.push_back(vertex);
+            cells[cell].push_back(match);
+        }
+
+        remap[i] = match;
+    }
+
+    using Face = std::array<int, 3>;
+
+    struct FaceHash
+    {
+        std::size_t operator()(const Face& face) const
+        {
+            return std::hash<std::int64_t>()(
+                static_cast<std::int64_t>(face[0]) << 42 ^
+                static_cast<std::int64_t>(face[1]) << 21 ^ face[2]);
+        }
+    };
+
+    std::unordered_set<Face, FaceHash> faces;
+    std::vector<int> cleaned;
+    cleaned.reserve(indices.size());
+
+    for (auto i = 0u; i + 2 < indices.size(); i += 3)
+    {
+        Face face {remap[indices[i + 0]], remap[indices[i + 1]],
+                   remap[indices[i + 2]]};
+
+        if (face[0] == face[1] || face[1] == face[2] || face[0] == face[2])
+            continue;
+
+        auto const normal = math::Vector3::CrossProduct(
+            welded[face[1]] - welded[face[0]], welded[face[2]] - welded[face[0]]);
+
+        if (normal.Length() <= epsilon * epsilon)
+            continue;
+
+        // rays hit only the front of a face, so the same face with the
+        // opposite winding is not a duplicate.  rotating the smallest index
+        // to the front keeps the winding
+        std::rotate(face.begin(), std::min_element(face.begin(), face.end()),
+                    face.end());
+
+        if (!faces.insert(face).second)
+            continue;
+
+        cleaned.insert(cleaned.end(), face.begin(), face.end());
+    }
+
+    // a model with nothing left to collide with is kept as it was, rather
+    // than written out with an empty tree
+    if (cleaned.empty())
+        return;
+
+    // the tree drops the vertices which are no longer used
+    vertices.swap(welded);
+    indices.swap(cleaned);
+}
 } // namespace
 
 MeshBuilder::MeshBuilder(const std::filesystem::path& outputPath,
@@ -889,7 +1007,13 @@ bool MeshBuilder::BuildAndSerializeWMOTile(int tileX, int tileY)
 
     if (++m_completedTiles == m_totalTiles)
     {
-        m_globalWMO->Serialize(m_outputPath / "Nav" / m_map->Name / "Map.nav");
+        auto const navPath = m_outputPath / "Nav" / m_map->Name;
+
+        m_globalWMO->Serialize(navPath / "Map.nav");
+
+        // a path oracle built for the previous navmesh no longer applies
+        std::error_code ec;
+        fs::remove(navPath / "Map.oracle", ec);
 
 #ifdef _DEBUG
         std::stringstream log;
@@ -1348,7 +1472,11 @@ void GlobalWMO::Serialize(const fs::path& filename) const
 
 void SerializeWmo(const parser::Wmo& wmo, BVHConstructor& constructor)
 {
-    math::AABBTree aabbTree(wmo.Vertices, wmo.Indices);
+    auto vertices = wmo.Vertices;
+    auto indices = wmo.Indices;
+    CleanCollisionMesh(vertices, indices);
+
+    math::AABBTree aabbTree(vertices, indices);
 
     utility::BinaryStream o;
     aabbTree.Serialize(o);
@@ -1388,7 +1516,11 @@ void SerializeWmo(const parser::Wmo& wmo, BVHConstructor& constructor)
 
 void SerializeDoodad(const parser::Doodad& doodad, const fs::path& path)
 {
-    math::AABBTree doodadTree(doodad.Vertices, doodad.Indices);
+    auto vertices = doodad.Vertices;
+    auto indices = doodad.Indices;
+    CleanCollisionMesh(vertices, indices);
+
+    math::AABBTree doodadTree(vertices, indices);
 
     utility::BinaryStream doodadOut;
     doodadTree.Serialize(doodadOut);
@@ -50,7 +50,7 @@ std::unique_ptr<pathfind::Map> gNavMesh;
 struct MouseDoodad
 {
     std::uint64_t Guid;
-    std::shared_ptr<pathfind::Model> Model;
+    std::shared_ptr<const pathfind::Model> Model;
 
     unsigned int DisplayId = 0;
 
@@ -76,13 +76,15 @@ void MoveMouseDoodad(math::Vertex const& position)
     gMouseDoodad->Position = position;
     UpdateMouseDoodadTransform();
 
-    auto vertices = gMouseDoodad->Model->m_aabbTree.Vertices();
+    auto const& tree = gMouseDoodad->Model->m_aabbTree;
+
+    std::vector<math::Vertex> vertices(tree.Vertices(),
+                                       tree.Vertices() + tree.VertexCount());
     for (auto& vertex : vertices)
         vertex = math::Vector3::Transform(vertex, gMouseDoodad->Transform);
 
     gRenderer->ClearGameObjects();
-    gRenderer->AddGameObject(vertices,
-                             gMouseDoodad->Model->m_aabbTree.Indices());
+    gRenderer->AddGameObject(vertices, tree.GetIndices());
 }
 
 void duDebugDrawNavMeshPolysWithoutFlags(struct duDebugDraw* dd,
@@ -17,6 +17,21 @@ BVH::BVH(const fs::path& path) : m_dataPath(path)
     std::uint32_t num_bvh, num_obstacles;
     index >> num_bvh;
 
+    // several mpq paths and display ids may share one .bvh file, which then
+    // gets a single id
+    std::unordered_map<std::string, ModelId> ids;
+
+    auto const intern = [this, &ids](const std::string& bvh_path)
+    {
+        auto const result =
+            ids.insert({bvh_path, static_cast<ModelId>(m_paths.size())});
+
+        if (result.second)
+            m_paths.push_back((m_dataPath / "BVH" / bvh_path).string());
+
+        return result.first->second;
+    };
+
     for (auto i = 0u; i < num_bvh; ++i)
     {
         std::uint32_t length;
@@ -28,7 +43,7 @@ BVH::BVH(const fs::path& path) : m_dataPath(path)
 
         auto const bvh_path = index.ReadString(length);
 
-        m_files[mpq_path] = bvh_path;
+        m_files[mpq_path] = intern(bvh_path);
     }
 
     index >> num_obstacles;
@@ -39,28 +54,28 @@ BVH::BVH(const fs::path& path) : m_dataPath(path)
 
         index >> entry >> length;
 
-        m_temporaryObstacles[entry] = index.ReadString(length);
+        m_temporaryObstacles[entry] = intern(index.ReadString(length));
     }
 }
 
-std::string BVH::GetBVHPath(const std::string& mpq_path) const
+ModelId BVH::GetModelId(const std::string& mpq_path) const
 {
     auto const result = m_files.find(mpq_path);
 
     if (result == m_files.end())
         THROW(Result::REQUESTED_BVH_NOT_FOUND);
 
-    return (m_dataPath / "BVH" / result->second).string();
+    return result->second;
 }
 
-std::string BVH::GetBVHPath(std::uint32_t entry) const
+ModelId BVH::GetModelId(std::uint32_t entry) const
 {
     auto const result = m_temporaryObstacles.find(entry);
 
     if (result == m_temporaryObstacles.end())
         THROW(Result::REQUESTED_BVH_NOT_FOUND);
 
-    return (m_dataPath / "BVH" / result->second).string();
+    return result->second;
 }
 
 std::string BVH::GetMPQPath(std::uint32_t entry) const
@@ -4,28 +4,40 @@
 #include <filesystem>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace fs = std::filesystem;
 
 namespace pathfind
 {
+// dense id of a .bvh file, assigned in the order the index lists them
+using ModelId = std::uint32_t;
+
 class BVH
 {
 private:
     const fs::path m_dataPath;
 
-    // map mpq path to .bvh path
-    std::unordered_map<std::string, std::string> m_files;
+    // full .bvh path of each model, indexed by id
+    std::vector<std::string> m_paths;
+
+    // map mpq path to model id
+    std::unordered_map<std::string, ModelId> m_files;
 
-    // map gameobject display id to .bvh path
-    std::unordered_map<int, std::string> m_temporaryObstacles;
+    // map gameobject display id to model id
+    std::unordered_map<std::uint32_t, ModelId> m_temporaryObstacles;
 
 public:
     BVH(const fs::path& path);
 
-    std::string GetBVHPath(const std::string& mpq_path) const;
-    std::string GetBVHPath(std::uint32_t entry) const;
+    ModelId GetModelId(const std::string& mpq_path) const;
+    ModelId GetModelId(std::uint32_t entry) const;
+
+    const std::string& GetBVHPath(ModelId id) const { return m_paths[id]; }
+
+    // ids are less than this
+    std::size_t ModelCount() const { return m_paths.size(); }
 
     std::string GetMPQPath(std::uint32_t entry) const;
 };
-} // namespace pathfind
\ No newline at end of file
+} // namespace pathfind
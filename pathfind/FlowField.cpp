@@ -0,0 +1,72 @@
+#include "FlowField.hpp"
+
+#include "Map.hpp"
+#include "Tile.hpp"
+#include "recastnavigation/Detour/Include/DetourNavMeshQuery.h"
+#include "utility/MathHelper.hpp"
+
+#include <memory>
+
+namespace pathfind
+{
+FlowField::FlowField(const PolyGraph& graph, dtPolyRef target,
+                     const float* targetPos, float maxCost)
+    : m_target(target), m_maxCost(maxCost)
+{
+    graph.Expand(target, targetPos, maxCost, m_nodes);
+
+    for (auto const& node : m_nodes)
+        m_tiles.insert(graph.TileIndex(node.first));
+}
+
+int FlowField::GetCorridor(dtPolyRef start, dtPolyRef* corridor,
+                           int maxCorridor) const
+{
+    int length = 0;
+
+    for (auto ref = start; !!ref;)
+    {
+        auto const node = m_nodes.find(ref);
+
+        if (node == m_nodes.end() || length == maxCorridor)
+            return 0;
+
+        corridor[length++] = ref;
+        ref = node->second.parent;
+    }
+
+    return length;
+}
+
+bool Map::BuildFlowField(const math::Vertex& target, float maxCost)
+{
+    constexpr float extents[] = {5.f, 5.f, 5.f};
+
+    float recastTarget[3];
+    math::Convert::VertexToRecast(target, recastTarget);
+
+    dtPolyRef targetRef;
+    if (!(m_navQuery.findNearestPoly(recastTarget, extents, &m_queryFilter,
+                                     &targetRef, nullptr) &
+          DT_SUCCESS) ||
+        !targetRef)
+        return false;
+
+    // an existing field which reaches at least as far can be reused as is
+    auto const existing = m_flowFields.find(targetRef);
+    if (existing != m_flowFields.end() &&
+        existing->second->MaxCost() >= maxCost)
+        return true;
+
+    const PolyGraph graph(m_navMesh, m_queryFilter);
+    m_flowFields[targetRef] =
+        std::make_unique<FlowField>(graph, targetRef, recastTarget, maxCost);
+
+    return true;
+}
+
+void Map::ClearFlowFields()
+{
+    m_flowFields.clear();
+}
+} // namespace pathfind
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "PolyGraph.hpp"
+#include "recastnavigation/Detour/Include/DetourNavMesh.h"
+
+#include <unordered_set>
+
+namespace pathfind
+{
+// a shortest path tree over the navmesh, rooted at a single target poly.  once
+// built, the corridor from any poly within the field to the target is read by
+// following parent links, with no further search required.
+class FlowField
+{
+private:
+    const dtPolyRef m_target;
+    const float m_maxCost;
+
+    PolyGraph::NodeMap m_nodes;
+
+    // indices of every navmesh tile with at least one poly in the field
+    std::unordered_set<unsigned int> m_tiles;
+
+public:
+    FlowField(const PolyGraph& graph, dtPolyRef target, const float* targetPos,
+              float maxCost);
+
+    dtPolyRef Target() const { return m_target; }
+    float MaxCost() const { return m_maxCost; }
+
+    bool UsesTile(unsigned int tileIndex) const
+    {
+        return m_tiles.find(tileIndex) != m_tiles.end();
+    }
+
+    // writes the corridor from 'start' to the target, returning its length.
+    // zero is returned if 'start' is not covered by the field or the corridor
+    // does not fit in the buffer
+    int GetCorridor(dtPolyRef start, dtPolyRef* corridor,
+                    int maxCorridor) const;
+};
+} // namespace pathfind
@@ -0,0 +1,162 @@
+#include "LineOfSightCache.hpp"
+
+#include "Map.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+
+namespace pathfind
+{
+LineOfSightCache::LineOfSightCache(std::size_t capacity) : m_capacity(capacity)
+{
+}
+
+LineOfSightCache::Key LineOfSightCache::MakeKey(const math::Vertex& start,
+                                                const math::Vertex& stop,
+                                                bool doodads,
+                                                bool navMeshFirst)
+{
+    auto const quantize = [](float value)
+    { return static_cast<std::int32_t>(std::lround(value / Quantum)); };
+
+    return {quantize(start.X), quantize(start.Y), quantize(start.Z),
+            quantize(stop.X),  quantize(stop.Y),  quantize(stop.Z),
+            doodads ? 1 : 0,   navMeshFirst ? 1 : 0};
+}
+
+void LineOfSightCache::Erase(std::list<Entry>::iterator entry)
+{
+    for (auto const& cell : entry->cells)
+    {
+        auto const i = m_cells.find(cell.first);
+
+        if (!--i->second.references)
+            m_cells.erase(i);
+    }
+
+    m_index.erase(entry->key);
+    m_entries.erase(entry);
+}
+
+template <typename F>
+void LineOfSightCache::ForEachCell(float minX, float minY, float maxX,
+                                   float maxY, F f)
+{
+    auto const x0 = static_cast<std::int32_t>(std::floor(minX / CellSize));
+    auto const y0 = static_cast<std::int32_t>(std::floor(minY / CellSize));
+    auto const x1 = static_cast<std::int32_t>(std::floor(maxX / CellSize));
+    auto const y1 = static_cast<std::int32_t>(std::floor(maxY / CellSize));
+
+    for (auto x = x0; x <= x1; ++x)
+        for (auto y = y0; y <= y1; ++y)
+            f((static_cast<std::uint64_t>(static_cast<std::uint32_t>(x))
+               << 32) |
+              static_cast<std::uint32_t>(y));
+}
+
+bool LineOfSightCache::Get(const math::Vertex& start, const math::Vertex& stop,
+                           bool doodads, bool navMeshFirst, bool& lineOfSight)
+{
+    auto const i = m_index.find(MakeKey(start, stop, doodads, navMeshFirst));
+
+    if (i == m_index.end())
+        return false;
+
+    auto const entry = i->second;
+
+    // the entry holds a reference to each of its cells, so they are present
+    for (auto const& cell : entry->cells)
+    {
+        if (m_cells.at(cell.first).version != cell.second)
+        {
+            Erase(entry);
+            return false;
+        }
+    }
+
+    lineOfSight = entry->lineOfSight;
+
+    // move the entry to the front
+    m_entries.splice(m_entries.begin(), m_entries, entry);
+
+    return true;
+}
+
+void LineOfSightCache::Insert(const math::Vertex& start,
+                              const math::Vertex& stop, bool doodads,
+                              bool navMeshFirst, bool lineOfSight)
+{
+    if (!m_capacity)
+        return;
+
+    auto const key = MakeKey(start, stop, doodads, navMeshFirst);
+
+    auto const existing = m_index.find(key);
+    if (existing != m_index.end())
+        Erase(existing->second);
+    else if (m_entries.size() == m_capacity)
+        Erase(std::prev(m_entries.end()));
+
+    Entry entry;
+    entry.key = key;
+    entry.lineOfSight = lineOfSight;
+
+    // the cells overlapping the bounds of the segment, padded by the
+    // quantum so that any segment sharing this key is also covered.  line of
+    // sight checks are short, so this is rarely more than a handful
+    ForEachCell((std::min)(start.X, stop.X) - Quantum,
+                (std::min)(start.Y, stop.Y) - Quantum,
+                (std::max)(start.X, stop.X) + Quantum,
+                (std::max)(start.Y, stop.Y) + Quantum,
+                [this, &entry](std::uint64_t cell)
+                {
+                    auto& state = m_cells[cell];
+                    ++state.references;
+                    entry.cells.emplace_back(cell, state.version);
+                });
+
+    m_entries.push_front(std::move(entry));
+    m_index[key] = m_entries.begin();
+}
+
+void LineOfSightCache::Invalidate(const math::BoundingBox& bounds)
+{
+    auto const& min = bounds.getMinimum();
+    auto const& max = bounds.getMaximum();
+
+    // a cell no entry crosses has nothing to invalidate
+    ForEachCell(min.X, min.Y, max.X, max.Y,
+                [this](std::uint64_t cell)
+                {
+                    auto const i = m_cells.find(cell);
+
+                    if (i != m_cells.end())
+                        ++i->second.version;
+                });
+}
+
+void LineOfSightCache::Clear()
+{
+    m_entries.clear();
+    m_index.clear();
+    m_cells.clear();
+}
+
+void Map::SetLineOfSightCacheCapacity(std::size_t capacity)
+{
+    if (!capacity)
+        m_lineOfSightCache.reset();
+    else if (!m_lineOfSightCache ||
+             m_lineOfSightCache->Capacity() != capacity)
+        m_lineOfSightCache = std::make_unique<LineOfSightCache>(capacity);
+}
+
+void Map::ClearLineOfSightCache()
+{
+    if (m_lineOfSightCache)
+        m_lineOfSightCache->Clear();
+}
+} // namespace pathfind
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "utility/BoundingBox.hpp"
+#include "utility/Vector.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace pathfind
+{
+// a bounded, least recently used cache of line of sight results.  endpoints
+// are snapped to a fine grid, so that repeated checks between casters and
+// targets which have not moved (or have moved by no more than a few
+// centimetres) share one entry.  the world is also divided into a coarse grid
+// of cells, each with a version which is bumped whenever an obstacle touching
+// it is added, and entries are discarded once any cell they cross changes.
+// only cells crossed by some entry are tracked, so the grid is no larger than
+// the cache itself
+class LineOfSightCache
+{
+public:
+    // tolerance of the endpoints, in yards
+    static constexpr float Quantum = 1.f / 16.f;
+    // size of the invalidation grid, in yards
+    static constexpr float CellSize = 32.f;
+
+private:
+    using Key = std::array<std::int32_t, 8>;
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const
+        {
+            std::size_t result = 0;
+            for (auto const k : key)
+                result = result * 0x9E3779B1u + static_cast<std::uint32_t>(k);
+            return result;
+        }
+    };
+
+    struct Entry
+    {
+        Key key;
+        bool lineOfSight;
+        // (cell, cell version) for every cell the segment may cross
+        std::vector<std::pair<std::uint64_t, std::uint32_t>> cells;
+    };
+
+    const std::size_t m_capacity;
+
+    // most recently used first
+    std::list<Entry> m_entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_index;
+
+    struct Cell
+    {
+        std::uint32_t version;
+        // number of entries crossing this cell
+        std::uint32_t references;
+    };
+
+    std::unordered_map<std::uint64_t, Cell> m_cells;
+
+    static Key MakeKey(const math::Vertex& start, const math::Vertex& stop,
+                       bool doodads, bool navMeshFirst);
+
+    // removes the entry, and forgets any cell no other entry crosses
+    void Erase(std::list<Entry>::iterator entry);
+
+    // calls f(cell) for every cell overlapping the given area
+    template <typename F>
+    static void ForEachCell(float minX, float minY, float maxX, float maxY,
+                            F f);
+
+public:
+    explicit LineOfSightCache(std::size_t capacity);
+
+    std::size_t Capacity() const { return m_capacity; }
+    std::size_t Size() const { return m_entries.size(); }
+
+    // returns false if there is no valid entry for the given check.  checks
+    // which may be answered by the navmesh are kept apart from those which
+    // may not, as the two can disagree
+    bool Get(const math::Vertex& start, const math::Vertex& stop,
+             bool doodads, bool navMeshFirst, bool& lineOfSight);
+
+    void Insert(const math::Vertex& start, const math::Vertex& stop,
+                bool doodads, bool navMeshFirst, bool lineOfSight);
+
+    // invalidates every entry crossing the given area
+    void Invalidate(const math::BoundingBox& bounds);
+
+    void Clear();
+};
+} // namespace pathfind
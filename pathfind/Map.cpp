@@ -1,28 +1,33 @@
 #include "Map.hpp"
 
 #include "Common.hpp"
+#include "ModelRepository.hpp"
 #include "Tile.hpp"
 #include "recastnavigation/Detour/Include/DetourCommon.h"
 #include "recastnavigation/Detour/Include/DetourNavMesh.h"
 #include "recastnavigation/Detour/Include/DetourNavMeshQuery.h"
 #include "utility/BinaryStream.hpp"
 #include "utility/Exception.hpp"
+#include "utility/MappedFile.hpp"
 #include "utility/MathHelper.hpp"
+#include "utility/Random.hpp"
 #include "utility/Ray.hpp"
 
 #include <algorithm>
 #include <cassert>
+#include <cfloat>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <limits>
 #include <list>
+#include <random>
 #include <sstream>
 #include <string>
 #include <unordered_set>
 #include <vector>
-#include <random>
 
 static_assert(sizeof(char) == 1, "char must be one byte");
 
@@ -47,6 +52,13 @@ struct DoodadFileInstance
     char m_fileName[MeshSettings::MaxMPQPathLength];
 };
 
+struct WmoDoodadFileEntry
+{
+    float m_transformMatrix[16];
+    math::BoundingBox m_bounds;
+    char m_fileName[MeshSettings::MaxMPQPathLength];
+};
+
 struct NavFileHeader
 {
     std::uint32_t sig;
@@ -82,12 +94,45 @@ struct NavFileHeader
 
 namespace {
 
+// detour's random point queries take a plain function pointer, with no
+// context argument, so the generator of the querying map is passed this way
+thread_local utility::Random* t_random = nullptr;
+
 float random_between_0_and_1() {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(0.0, 1.0);
+    return t_random->NextFloat();
+}
+
+// tests a ray, already transformed into the space of a wmo, against the
+// doodads placed in it by one of its doodad sets.  'ray' is the original ray,
+// whose hit point is moved if one of them is hit closer
+bool IntersectDoodadSet(const pathfind::DoodadSet& doodadSet,
+                        const math::Ray& wmoRay, math::Ray& ray)
+{
+    auto hit = false;
+
+    for (auto i = 0u; i < doodadSet.m_doodads.size(); ++i)
+    {
+        auto const& doodad = doodadSet.m_doodads[i];
 
-    return static_cast<float>(dis(gen));
+        if (!wmoRay.IntersectBoundingBox(doodad.m_bounds))
+            continue;
+
+        math::Ray doodadRay(
+            math::Vector3::Transform(wmoRay.GetStartPoint(),
+                                     doodad.m_inverseTransformMatrix),
+            math::Vector3::Transform(wmoRay.GetEndPoint(),
+                                     doodad.m_inverseTransformMatrix));
+
+        // the set keeps the models of its doodads loaded
+        if (doodadSet.m_models[i]->m_aabbTree.IntersectRay(doodadRay) &&
+            doodadRay.GetDistance() < ray.GetDistance())
+        {
+            hit = true;
+            ray.SetHitPoint(doodadRay.GetDistance());
+        }
+    }
+
+    return hit;
 }
 
 } // anonymous namespace
@@ -96,7 +141,9 @@ namespace pathfind
 {
 Map::Map(const std::filesystem::path& dataPath, const std::string& mapName)
     : m_dataPath(dataPath), m_bvhLoader(dataPath), m_mapName(mapName),
-      m_globalWmoOriginX(0.f), m_globalWmoOriginY(0.f)
+      m_globalWmoOriginX(0.f), m_globalWmoOriginY(0.f),
+      m_random(std::random_device()()), m_gameObjectBatch(false),
+      m_backgroundRebuilds(false)
 {
     utility::BinaryStream in(m_dataPath / (mapName + ".map"));
 
@@ -108,6 +155,9 @@ Map::Map(const std::filesystem::path& dataPath, const std::string& mapName)
 
     ::memset(m_loadedADT, 0, sizeof(m_loadedADT));
 
+    m_wmoModels.resize(m_bvhLoader.ModelCount());
+    m_doodadModels.resize(m_bvhLoader.ModelCount());
+
     std::uint8_t hasTerrain;
     in >> hasTerrain;
 
@@ -170,7 +220,7 @@ Map::Map(const std::filesystem::path& dataPath, const std::string& mapName)
                 ins.m_inverseTransformMatrix =
                     ins.m_transformMatrix.ComputeInverse();
                 ins.m_bounds = wmo.m_bounds;
-                ins.m_modelFilename = wmo.m_fileName;
+                ins.m_modelId = m_bvhLoader.GetModelId(wmo.m_fileName);
 
                 m_staticWmos.insert({static_cast<unsigned int>(wmo.m_id), ins});
             }
@@ -197,7 +247,7 @@ Map::Map(const std::filesystem::path& dataPath, const std::string& mapName)
                 ins.m_inverseTransformMatrix =
                     ins.m_transformMatrix.ComputeInverse();
                 ins.m_bounds = doodad.m_bounds;
-                ins.m_modelFilename = doodad.m_fileName;
+                ins.m_modelId = m_bvhLoader.GetModelId(doodad.m_fileName);
 
                 m_staticDoodads.insert(
                     {static_cast<unsigned int>(doodad.m_id), ins});
@@ -223,8 +273,9 @@ Map::Map(const std::filesystem::path& dataPath, const std::string& mapName)
                 sizeof(globalWmo.m_transformMatrix[0]));
         ins.m_inverseTransformMatrix = ins.m_transformMatrix.ComputeInverse();
         ins.m_bounds = globalWmo.m_bounds;
+        ins.m_modelId = m_bvhLoader.GetModelId(globalWmo.m_fileName);
 
-        auto model = EnsureWmoModelLoaded(globalWmo.m_fileName);
+        auto model = EnsureWmoModelLoaded(ins.m_modelId);
         ins.m_model = model;
 
         m_staticWmos.insert({GlobalWmoId, ins});
@@ -274,16 +325,30 @@ Map::Map(const std::filesystem::path& dataPath, const std::string& mapName)
             // for a global wmo, all tiles are guarunteed to contain the model
             tile->m_staticWmos.push_back(GlobalWmoId);
             tile->m_staticWmoModels.push_back(model);
+            tile->m_staticWmoDoodadSets.emplace_back();
+            IndexStaticInstances(*tile);
 
             m_tiles[{tile->m_x, tile->m_y}] = std::move(tile);
         }
+
+        auto const oraclePath = m_dataPath / "Nav" / m_mapName / "Map.oracle";
+
+        if (fs::exists(oraclePath))
+        {
+            utility::BinaryStream oracleIn(oraclePath);
+
+            oracleIn.Decompress();
+
+            m_pathOracle = PathOracle::Load(oracleIn, m_navMesh);
+        }
     }
 
     if (m_navQuery.init(&m_navMesh, 65535) != DT_SUCCESS)
         THROW(Result::DTNAVMESHQUERY_INIT_FAILED);
 }
 
-std::shared_ptr<WmoModel> Map::LoadModelForWmoInstance(unsigned int instanceId)
+std::shared_ptr<const WmoModel>
+Map::LoadModelForWmoInstance(unsigned int instanceId) const
 {
     auto const instance = m_staticWmos.find(instanceId);
 
@@ -295,15 +360,15 @@ std::shared_ptr<WmoModel> Map::LoadModelForWmoInstance(unsigned int instanceId)
     if (!instance->second.m_model.expired())
         return instance->second.m_model.lock();
 
-    auto model = EnsureWmoModelLoaded(instance->second.m_modelFilename);
+    auto model = EnsureWmoModelLoaded(instance->second.m_modelId);
 
     instance->second.m_model = model;
 
     return model;
 }
 
-std::shared_ptr<DoodadModel>
-Map::LoadModelForDoodadInstance(unsigned int instanceId)
+std::shared_ptr<const DoodadModel>
+Map::LoadModelForDoodadInstance(unsigned int instanceId) const
 {
     auto const instance = m_staticDoodads.find(instanceId);
 
@@ -315,105 +380,257 @@ Map::LoadModelForDoodadInstance(unsigned int instanceId)
     if (!instance->second.m_model.expired())
         return instance->second.m_model.lock();
 
-    auto model = EnsureDoodadModelLoaded(instance->second.m_modelFilename);
+    auto model = EnsureDoodadModelLoaded(instance->second.m_modelId);
 
     instance->second.m_model = model;
 
     return model;
 }
 
-std::shared_ptr<DoodadModel>
-Map::EnsureDoodadModelLoaded(const std::string& mpq_path)
+std::shared_ptr<const WmoModel> Map::GetStaticWmoModel(const Tile& tile,
+                                                      std::size_t index) const
 {
-    auto const bvhFilename = m_bvhLoader.GetBVHPath(mpq_path);
+    auto& model = tile.m_staticWmoModels[index];
+
+    if (!model)
+        model = LoadModelForWmoInstance(tile.m_staticWmos[index]);
 
-    // if this model is currently loaded, return it
-    auto const i = m_loadedDoodadModels.find(bvhFilename);
-    if (i != m_loadedDoodadModels.end() && !i->second.expired())
-        return i->second.lock();
+    return model;
+}
 
-    // else, load it
-    utility::BinaryStream in(bvhFilename);
+std::shared_ptr<const DoodadSet>
+Map::GetStaticWmoDoodadSet(const Tile& tile, std::size_t index) const
+{
+    auto& doodadSet = tile.m_staticWmoDoodadSets[index];
 
-    auto model = std::make_shared<pathfind::DoodadModel>();
+    if (!doodadSet)
+    {
+        auto const model = GetStaticWmoModel(tile, index);
 
-    if (!model->m_aabbTree.Deserialize(in))
-        THROW(Result::COULD_NOT_DESERIALIZE_DOODAD).ErrorCode();
+        doodadSet = EnsureDoodadSetLoaded(
+            *model, m_staticWmos.at(tile.m_staticWmos[index]).m_doodadSet);
+    }
 
-    m_loadedDoodadModels[bvhFilename] = model;
-    return model;
+    return doodadSet;
 }
 
-std::shared_ptr<WmoModel> Map::EnsureWmoModelLoaded(const std::string& mpq_path)
+std::shared_ptr<const DoodadModel>
+Map::GetStaticDoodadModel(const Tile& tile, std::size_t index) const
 {
-    auto const bvhFilename = m_bvhLoader.GetBVHPath(mpq_path);
+    auto& model = tile.m_staticDoodadModels[index];
 
-    // if this model is currently loaded, return it
-    auto const i = m_loadedWmoModels.find(bvhFilename);
-    if (i != m_loadedWmoModels.end() && !i->second.expired())
-        return i->second.lock();
+    if (!model)
+        model = LoadModelForDoodadInstance(tile.m_staticDoodads[index]);
 
-    // else, load it
-    utility::BinaryStream in(bvhFilename);
-
-    auto model = std::make_shared<pathfind::WmoModel>();
+    return model;
+}
 
-    if (!model->m_aabbTree.Deserialize(in))
-        THROW(Result::COULD_NOT_DESERIALIZE_WMO).ErrorCode();
+int Map::WarmUpModels(const math::Vertex& center, float radius)
+{
+    const math::BoundingBox area {
+        {center.X - radius, center.Y - radius, center.Z - radius},
+        {center.X + radius, center.Y + radius, center.Z + radius}};
 
-    std::uint32_t rootId, nameSetCount;
-    in >> rootId >> nameSetCount;
+    int result = 0;
 
-    for (auto i = 0u; i < nameSetCount; ++i)
+    for (auto const& tile : m_tiles)
     {
-        std::uint32_t nameSet, areaId, zoneId;
-        in >> nameSet >> areaId >> zoneId;
+        if (!tile.second->m_bounds.intersect2d(area))
+            continue;
 
-        model->m_nameSetToAreaZone[nameSet] = {areaId, zoneId};
+        for (auto i = 0u; i < tile.second->m_staticWmos.size(); ++i)
+        {
+            if (!!tile.second->m_staticWmoModels[i] ||
+                !m_staticWmos.at(tile.second->m_staticWmos[i])
+                     .m_bounds.intersect2d(area))
+                continue;
+
+            GetStaticWmoModel(*tile.second, i);
+            ++result;
+        }
+
+        for (auto i = 0u; i < tile.second->m_staticDoodads.size(); ++i)
+        {
+            if (!!tile.second->m_staticDoodadModels[i] ||
+                !m_staticDoodads.at(tile.second->m_staticDoodads[i])
+                     .m_bounds.intersect2d(area))
+                continue;
+
+            GetStaticDoodadModel(*tile.second, i);
+            ++result;
+        }
     }
 
-    std::uint32_t doodadSetCount;
-    in >> doodadSetCount;
+    return result;
+}
 
-    model->m_doodadSets.resize(doodadSetCount);
-    model->m_loadedDoodadSets.resize(doodadSetCount);
+std::shared_ptr<const DoodadModel>
+Map::EnsureDoodadModelLoaded(ModelId id) const
+{
+    auto& cached = m_doodadModels[id];
 
-    for (std::uint32_t set = 0; set < doodadSetCount; ++set)
-    {
-        std::uint32_t doodadSetSize;
-        in >> doodadSetSize;
+    if (auto model = cached.lock())
+        return model;
 
-        model->m_doodadSets[set].resize(doodadSetSize);
+    auto const& bvhFilename = m_bvhLoader.GetBVHPath(id);
 
-        for (std::uint32_t doodad = 0; doodad < doodadSetSize; ++doodad)
+    // if this model is currently loaded by any map, it is returned as is
+    auto model = ModelRepository::Instance().GetDoodadModel(
+        bvhFilename,
+        [&bvhFilename]()
         {
-            float transformMatrix[16];
-            in >> transformMatrix;
+            auto const file =
+                std::make_shared<const utility::MappedFile>(bvhFilename);
 
-            model->m_doodadSets[set][doodad].m_transformMatrix =
-                math::Matrix::CreateFromArray(transformMatrix,
-                                              sizeof(transformMatrix) /
-                                                  sizeof(transformMatrix[0]));
+            auto model = std::make_unique<pathfind::DoodadModel>();
 
-            in >> model->m_doodadSets[set][doodad].m_bounds;
+            std::size_t offset = 0;
+            if (!model->m_aabbTree.Deserialize(file, offset))
+                THROW(Result::COULD_NOT_DESERIALIZE_DOODAD).ErrorCode();
 
-            char doodadFileName[MeshSettings::MaxMPQPathLength];
-            in >> doodadFileName;
+            if (ModelRepository::Instance().QuantizeModels())
+                model->m_aabbTree.Quantize();
 
-            auto doodadModel = EnsureDoodadModelLoaded(doodadFileName);
+            return model;
+        });
 
-            // loaded doodads serve as reference counters for automatic unload
-            model->m_loadedDoodadSets[set].push_back(doodadModel);
-            model->m_doodadSets[set][doodad].m_model =
-                m_loadedDoodadModels[doodadFileName] = doodadModel;
-        }
-    }
+    cached = model;
+
+    return model;
+}
+
+std::shared_ptr<const WmoModel> Map::EnsureWmoModelLoaded(ModelId id) const
+{
+    auto& cached = m_wmoModels[id];
+
+    if (auto model = cached.lock())
+        return model;
+
+    auto const& bvhFilename = m_bvhLoader.GetBVHPath(id);
+
+    // if this model is currently loaded by any map, it is returned as is
+    auto model = ModelRepository::Instance().GetWmoModel(
+        bvhFilename,
+        [&bvhFilename]()
+        {
+            auto const file =
+                std::make_shared<const utility::MappedFile>(bvhFilename);
+
+            auto model = std::make_unique<pathfind::WmoModel>();
+
+            std::size_t offset = 0;
+            if (!model->m_aabbTree.Deserialize(file, offset))
+                THROW(Result::COULD_NOT_DESERIALIZE_WMO).ErrorCode();
+
+            if (ModelRepository::Instance().QuantizeModels())
+                model->m_aabbTree.Quantize();
+
+            // the remainder of the file is small, and is read directly from
+            // the mapping
+            auto const read = [&file, &offset](std::uint32_t& value)
+            {
+                if (!file->Read(offset, value))
+                    THROW(Result::COULD_NOT_DESERIALIZE_WMO);
+            };
 
-    m_loadedWmoModels[bvhFilename] = model;
+            std::uint32_t rootId, nameSetCount;
+            read(rootId);
+            read(nameSetCount);
+
+            for (auto i = 0u; i < nameSetCount; ++i)
+            {
+                std::uint32_t nameSet, areaId, zoneId;
+                read(nameSet);
+                read(areaId);
+                read(zoneId);
+
+                model->m_nameSetToAreaZone[nameSet] = {areaId, zoneId};
+            }
+
+            std::uint32_t doodadSetCount;
+            read(doodadSetCount);
+
+            model->m_bvhPath = bvhFilename;
+            model->m_file = file;
+            model->m_doodadSetLocations.reserve(doodadSetCount);
+
+            // large wmos carry many doodad sets, of which an instance uses
+            // only one.  the entries are of fixed size, so each set is
+            // skipped over here and read by EnsureDoodadSetLoaded() once an
+            // instance needs its doodads
+            for (std::uint32_t set = 0; set < doodadSetCount; ++set)
+            {
+                std::uint32_t doodadSetSize;
+                read(doodadSetSize);
+
+                model->m_doodadSetLocations.emplace_back(offset, doodadSetSize);
+                offset += doodadSetSize * sizeof(WmoDoodadFileEntry);
+            }
+
+            return model;
+        });
+
+    cached = model;
 
     return model;
 }
 
+std::shared_ptr<const DoodadSet>
+Map::EnsureDoodadSetLoaded(const WmoModel& model, unsigned int set) const
+{
+    if (set >= model.m_doodadSetLocations.size())
+        return nullptr;
+
+    // if this set is currently loaded by any map, it is returned as is
+    return ModelRepository::Instance().GetDoodadSet(
+        model.m_bvhPath, set,
+        [this, &model, set]()
+        {
+            auto const& location = model.m_doodadSetLocations[set];
+
+            std::vector<WmoDoodadFileEntry> entries(location.second);
+
+            // the model kept the mapping its tree was read from
+            if (!entries.empty())
+            {
+                auto const size = entries.size() * sizeof(WmoDoodadFileEntry);
+
+                if (location.first + size > model.m_file->Size())
+                    THROW(Result::COULD_NOT_DESERIALIZE_WMO);
+
+                std::memcpy(&entries[0], model.m_file->Data() + location.first,
+                            size);
+            }
+
+            auto result = std::make_unique<DoodadSet>();
+
+            result->m_doodads.resize(entries.size());
+            result->m_models.reserve(entries.size());
+
+            for (auto i = 0u; i < entries.size(); ++i)
+            {
+                auto& doodad = result->m_doodads[i];
+
+                doodad.m_transformMatrix = math::Matrix::CreateFromArray(
+                    entries[i].m_transformMatrix,
+                    sizeof(entries[i].m_transformMatrix) /
+                        sizeof(entries[i].m_transformMatrix[0]));
+                doodad.m_inverseTransformMatrix =
+                    doodad.m_transformMatrix.ComputeInverse();
+                doodad.m_bounds = entries[i].m_bounds;
+                doodad.m_modelId =
+                    m_bvhLoader.GetModelId(entries[i].m_fileName);
+
+                auto doodadModel = EnsureDoodadModelLoaded(doodad.m_modelId);
+
+                result->m_models.push_back(doodadModel);
+                doodad.m_model = doodadModel;
+            }
+
+            return result;
+        });
+}
+
 bool Map::HasADTs() const
 {
     return m_hasADTs;
@@ -459,14 +676,28 @@ bool Map::LoadADT(int x, int y)
         header.y != static_cast<std::uint32_t>(y))
         THROW(Result::INCORRECT_ADT_COORDINATES);
 
+    std::vector<Tile*> obstructed;
+
     for (auto i = 0u; i < header.tileCount; ++i)
     {
         auto tile = std::make_unique<Tile>(this, stream, nav_path);
+        IndexStaticInstances(*tile);
+
+        if (AddTemporaryObstacles(*tile))
+            obstructed.push_back(tile.get());
+
         m_tiles[{tile->m_x, tile->m_y}] = std::move(tile);
     }
 
+    // tiles which already have obstacles are rebuilt once, together
+    RebuildTiles(obstructed);
+
     m_loadedADT[x][y] = true;
 
+    // the new tiles may offer shorter routes than those already cached
+    ClearPathCache();
+    ClearLineOfSightCache();
+
     return true;
 }
 
@@ -482,11 +713,20 @@ void Map::UnloadADT(int x, int y)
         {
             auto i = m_tiles.find({tileX, tileY});
 
-            if (i != m_tiles.end())
-                m_tiles.erase(i);
+            if (i == m_tiles.end())
+                continue;
+
+            // obstacles still held by other tiles remain registered, and
+            // are added again should the tile be reloaded
+            CancelTileRebuild(i->first);
+            m_tiles.erase(i);
         }
 
+    PruneTemporaryObstacles();
+
     m_loadedADT[x][y] = false;
+
+    ClearLineOfSightCache();
 }
 
 int Map::LoadAllADTs()
@@ -501,10 +741,11 @@ int Map::LoadAllADTs()
     return result;
 }
 
-std::shared_ptr<Model> Map::GetOrLoadModelByDisplayId(unsigned int displayId)
+std::shared_ptr<const Model>
+Map::GetOrLoadModelByDisplayId(unsigned int displayId)
 {
     // Get the BVH file for this display ID
-    auto const bvh_path = m_bvhLoader.GetBVHPath(displayId);
+    auto const modelId = m_bvhLoader.GetModelId(displayId);
 
     // TODO: add logic based on mpq_path
     auto const doodad = false;
@@ -516,7 +757,7 @@ std::shared_ptr<Model> Map::GetOrLoadModelByDisplayId(unsigned int displayId)
         // if (i != m_loadedDoodadModels.end() && !i->second.expired())
         //    return i->second.lock();
 
-        return EnsureDoodadModelLoaded(bvh_path);
+        return EnsureDoodadModelLoaded(modelId);
     }
     else
     {
@@ -524,14 +765,80 @@ std::shared_ptr<Model> Map::GetOrLoadModelByDisplayId(unsigned int displayId)
         // if (i != m_loadedWmoModels.end() && !i->second.expired())
         //    return i->second.lock();
 
-        return EnsureWmoModelLoaded(bvh_path);
+        return EnsureWmoModelLoaded(modelId);
     }
 
     // return nullptr;
 }
 
+void Map::OnTileChanged(const Tile& tile)
+{
+    if (!tile.m_ref)
+        return;
+
+    auto const tileIndex = m_navMesh.decodePolyIdTile(tile.m_ref);
+
+    // the dense poly ids assigned by the oracle no longer match the navmesh
+    m_pathOracle.reset();
+
+    if (m_pathCache)
+        m_pathCache->OnTileChanged(tileIndex);
+
+    // a navmesh line of sight through the old tile may not hold for the new
+    if (m_lineOfSightCache)
+        m_lineOfSightCache->Invalidate(tile.m_bounds);
+
+    // the polys of this tile are about to be invalidated, so any field
+    // passing through it must be discarded
+    for (auto i = m_flowFields.begin(); i != m_flowFields.end();)
+    {
+        if (i->second->UsesTile(tileIndex))
+            i = m_flowFields.erase(i);
+        else
+            ++i;
+    }
+}
+
+bool Map::IsDirectlyWalkable(dtPolyRef startRef, const float* start,
+                             dtPolyRef endRef, const float* end,
+                             dtPolyRef* buffer, int bufferSize,
+                             float* snappedStart, float* snappedEnd,
+                             int* corridorSize) const
+{
+    if (!(m_navQuery.closestPointOnPoly(startRef, start, snappedStart,
+                                        nullptr) &
+          DT_SUCCESS) ||
+        !(m_navQuery.closestPointOnPoly(endRef, end, snappedEnd, nullptr) &
+          DT_SUCCESS))
+        return false;
+
+    dtRaycastHit hit;
+    hit.path = buffer;
+    hit.maxPath = bufferSize;
+
+    if (!(m_navQuery.raycast(startRef, snappedStart, snappedEnd,
+                             &m_queryFilter, 0, &hit) &
+          DT_SUCCESS))
+        return false;
+
+    if (corridorSize)
+        *corridorSize = hit.pathCount;
+
+    // the ray must not only reach the end position, but do so in the end
+    // poly, rather than in another poly above or below it
+    return hit.t == FLT_MAX && hit.pathCount > 0 &&
+           hit.path[hit.pathCount - 1] == endRef;
+}
+
 bool Map::FindPath(const math::Vertex& start, const math::Vertex& end,
                    std::vector<math::Vertex>& output, bool allowPartial) const
+{
+    return FindStraightPath(start, end, output, allowPartial, nullptr);
+}
+
+bool Map::FindStraightPath(const math::Vertex& start, const math::Vertex& end,
+                           std::vector<math::Vertex>& output, bool allowPartial,
+                           std::vector<dtPolyRef>* polyRefs) const
 {
     constexpr float extents[] = {5.f, 5.f, 5.f};
 
@@ -558,24 +865,84 @@ bool Map::FindPath(const math::Vertex& start, const math::Vertex& end,
     if (!endPolyRef)
         return false;
 
+    ++m_statistics.pathQueries;
+
     dtPolyRef polyRefBuffer[MaxPathHops];
 
-    int pathLength;
-    auto const findPathResult = m_navQuery.findPath(
-        startPolyRef, endPolyRef, recastStart, recastEnd, &m_queryFilter,
-        polyRefBuffer, &pathLength, MaxPathHops);
-    if (!(findPathResult & DT_SUCCESS) ||
-        (!allowPartial && !!(findPathResult & DT_PARTIAL_RESULT)))
-        return false;
+    // many requests are short moves with nothing in the way, which need no
+    // search at all
+    float directStart[3], directEnd[3];
+    if (IsDirectlyWalkable(startPolyRef, recastStart, endPolyRef, recastEnd,
+                           polyRefBuffer, MaxPathHops, directStart, directEnd))
+    {
+        ++m_statistics.directPaths;
+
+        output.resize(2);
+        math::Convert::VertexToWow(directStart, output[0]);
+        math::Convert::VertexToWow(directEnd, output[1]);
+
+        if (polyRefs)
+            *polyRefs = {startPolyRef, endPolyRef};
+
+        return true;
+    }
+
+    // if a flow field was built toward the end poly and it covers the start
+    // poly, or if this map has a path oracle, the corridor is already known.
+    // each is tried in turn, and a miss in one falls through to the next
+    int pathLength = 0;
+    auto const flowField = m_flowFields.find(endPolyRef);
+    if (flowField != m_flowFields.end())
+    {
+        pathLength = flowField->second->GetCorridor(startPolyRef,
+                                                    polyRefBuffer, MaxPathHops);
+        if (pathLength)
+            ++m_statistics.flowFieldHits;
+    }
+
+    if (!pathLength && m_pathOracle)
+        pathLength = m_pathOracle->GetCorridor(startPolyRef, endPolyRef,
+                                               polyRefBuffer, MaxPathHops);
+
+    if (!pathLength && m_pathCache)
+    {
+        pathLength = m_pathCache->Get(startPolyRef, endPolyRef, polyRefBuffer,
+                                      MaxPathHops);
+
+        if (pathLength)
+            ++m_statistics.pathCacheHits;
+        else
+            ++m_statistics.pathCacheMisses;
+    }
+
+    if (!pathLength)
+    {
+        auto const findPathResult = m_navQuery.findPath(
+            startPolyRef, endPolyRef, recastStart, recastEnd, &m_queryFilter,
+            polyRefBuffer, &pathLength, MaxPathHops);
+        if (!(findPathResult & DT_SUCCESS) ||
+            (!allowPartial && !!(findPathResult & DT_PARTIAL_RESULT)))
+            return false;
+
+        // partial corridors do not reach the end poly, so must not be kept
+        if (m_pathCache && !(findPathResult & DT_PARTIAL_RESULT))
+            m_pathCache->Insert(polyRefBuffer, pathLength);
+    }
+
+    if (polyRefs)
+        polyRefs->resize(MaxPathHops);
 
     float pathBuffer[MaxPathHops * 3];
     auto const findStraightPathResult = m_navQuery.findStraightPath(
         recastStart, recastEnd, polyRefBuffer, pathLength, pathBuffer, nullptr,
-        nullptr, &pathLength, MaxPathHops);
+        polyRefs ? polyRefs->data() : nullptr, &pathLength, MaxPathHops);
     if (!(findStraightPathResult & DT_SUCCESS) ||
         (!allowPartial && !!(findStraightPathResult & DT_PARTIAL_RESULT)))
         return false;
 
+    if (polyRefs)
+        polyRefs->resize(pathLength);
+
     output.resize(pathLength);
 
     for (auto i = 0; i < pathLength; ++i)
@@ -584,6 +951,252 @@ bool Map::FindPath(const math::Vertex& start, const math::Vertex& end,
     return true;
 }
 
+bool Map::PathDistance(const math::Vertex& start, const math::Vertex& end,
+                       float maxDistance, float& distance) const
+{
+    constexpr float extents[] = {5.f, 5.f, 5.f};
+
+    float recastStart[3];
+    float recastEnd[3];
+
+    math::Convert::VertexToRecast(start, recastStart);
+    math::Convert::VertexToRecast(end, recastEnd);
+
+    dtPolyRef startPolyRef, endPolyRef;
+    if (!(m_navQuery.findNearestPoly(recastStart, extents, &m_queryFilter,
+                                     &startPolyRef, nullptr) &
+          DT_SUCCESS) ||
+        !startPolyRef)
+        return false;
+
+    if (!(m_navQuery.findNearestPoly(recastEnd, extents, &m_queryFilter,
+                                     &endPolyRef, nullptr) &
+          DT_SUCCESS) ||
+        !endPolyRef)
+        return false;
+
+    dtPolyRef polyRefBuffer[MaxStackedPolys];
+
+    float directStart[3], directEnd[3];
+    if (IsDirectlyWalkable(startPolyRef, recastStart, endPolyRef, recastEnd,
+                           polyRefBuffer, MaxStackedPolys, directStart,
+                           directEnd))
+    {
+        distance = dtVdist(directStart, directEnd);
+        return distance <= maxDistance;
+    }
+
+    const PolyGraph graph(m_navMesh, m_queryFilter);
+    return graph.Search(startPolyRef, recastStart, endPolyRef, recastEnd,
+                        maxDistance, m_searchNodes, distance);
+}
+
+bool Map::PathDistances(const math::Vertex& start,
+                        const std::vector<math::Vertex>& ends,
+                        float maxDistance, std::vector<float>& distances) const
+{
+    constexpr float extents[] = {5.f, 5.f, 5.f};
+
+    float recastStart[3];
+    math::Convert::VertexToRecast(start, recastStart);
+
+    dtPolyRef startPolyRef;
+    if (!(m_navQuery.findNearestPoly(recastStart, extents, &m_queryFilter,
+                                     &startPolyRef, nullptr) &
+          DT_SUCCESS) ||
+        !startPolyRef)
+        return false;
+
+    // a single expansion from the start, bounded by the distance, serves
+    // every end point
+    const PolyGraph graph(m_navMesh, m_queryFilter);
+    m_searchNodes.clear();
+    graph.Expand(startPolyRef, recastStart, maxDistance, m_searchNodes);
+
+    distances.resize(ends.size());
+
+    dtPolyRef polyRefBuffer[MaxStackedPolys];
+
+    for (auto i = 0u; i < ends.size(); ++i)
+    {
+        distances[i] = std::numeric_limits<float>::infinity();
+
+        float recastEnd[3];
+        math::Convert::VertexToRecast(ends[i], recastEnd);
+
+        dtPolyRef endPolyRef;
+        if (!(m_navQuery.findNearestPoly(recastEnd, extents, &m_queryFilter,
+                                         &endPolyRef, nullptr) &
+              DT_SUCCESS) ||
+            !endPolyRef)
+            continue;
+
+        // as in PathDistance(), an end point in plain view is measured in a
+        // straight line, so that both give the same answer for it
+        float directStart[3], directEnd[3];
+        if (IsDirectlyWalkable(startPolyRef, recastStart, endPolyRef,
+                               recastEnd, polyRefBuffer, MaxStackedPolys,
+                               directStart, directEnd))
+        {
+            auto const direct = dtVdist(directStart, directEnd);
+
+            if (direct <= maxDistance)
+                distances[i] = direct;
+
+            continue;
+        }
+
+        auto const node = m_searchNodes.find(endPolyRef);
+        if (node == m_searchNodes.end())
+            continue;
+
+        auto const total =
+            node->second.cost +
+            graph.Cost(node->second.pos, recastEnd, endPolyRef);
+
+        if (total <= maxDistance)
+            distances[i] = total;
+    }
+
+    return true;
+}
+
+bool Map::PolysWithinPathDistance(const math::Vertex& center, float radius,
+                                  PolyDistances& result) const
+{
+    constexpr float extents[] = {5.f, 5.f, 5.f};
+
+    float recastCenter[3];
+    math::Convert::VertexToRecast(center, recastCenter);
+
+    dtPolyRef centerPolyRef;
+    if (!(m_navQuery.findNearestPoly(recastCenter, extents, &m_queryFilter,
+                                     &centerPolyRef, nullptr) &
+          DT_SUCCESS) ||
+        !centerPolyRef)
+        return false;
+
+    const PolyGraph graph(m_navMesh, m_queryFilter);
+    m_searchNodes.clear();
+    graph.Expand(centerPolyRef, recastCenter, radius, m_searchNodes);
+
+    result.clear();
+    result.reserve(m_searchNodes.size());
+
+    for (auto const& node : m_searchNodes)
+    {
+        ReachablePoly poly;
+        poly.poly = node.first;
+        poly.distance = node.second.cost;
+        math::Convert::VertexToWow(node.second.pos, poly.entry);
+
+        result.push_back(poly);
+    }
+
+    std::sort(result.begin(), result.end(),
+              [](const ReachablePoly& a, const ReachablePoly& b)
+              { return a.poly < b.poly; });
+
+    return true;
+}
+
+void Map::DistancesFromPolySet(const PolyDistances& polys, float radius,
+                               const std::vector<math::Vertex>& positions,
+                               std::vector<float>& distances) const
+{
+    constexpr float extents[] = {5.f, 5.f, 5.f};
+
+    const PolyGraph graph(m_navMesh, m_queryFilter);
+
+    distances.resize(positions.size());
+
+    for (auto i = 0u; i < positions.size(); ++i)
+    {
+        distances[i] = std::numeric_limits<float>::infinity();
+
+        float recastPosition[3];
+        math::Convert::VertexToRecast(positions[i], recastPosition);
+
+        dtPolyRef polyRef;
+        if (!(m_navQuery.findNearestPoly(recastPosition, extents,
+                                         &m_queryFilter, &polyRef, nullptr) &
+              DT_SUCCESS) ||
+            !polyRef)
+            continue;
+
+        auto const poly = std::lower_bound(
+            polys.begin(), polys.end(), polyRef,
+            [](const ReachablePoly& entry, dtPolyRef ref)
+            { return entry.poly < ref; });
+
+        if (poly == polys.end() || poly->poly != polyRef)
+            continue;
+
+        // a large poly may be entered well within the radius, and yet hold
+        // positions far beyond it
+        float recastEntry[3];
+        math::Convert::VertexToRecast(poly->entry, recastEntry);
+
+        auto const total =
+            poly->distance + graph.Cost(recastEntry, recastPosition, polyRef);
+
+        if (total <= radius)
+            distances[i] = total;
+    }
+}
+
+void Map::IndexStaticInstances(Tile& tile) const
+{
+    // static instances are only ever added when the map is loaded, so
+    // pointers to them remain valid for as long as the map exists
+    tile.m_staticWmoInstances.clear();
+    tile.m_staticWmoBounds.Clear();
+    tile.m_staticWmoBounds.Reserve(tile.m_staticWmos.size());
+
+    for (auto const id : tile.m_staticWmos)
+    {
+        auto const& instance = m_staticWmos.at(id);
+
+        tile.m_staticWmoInstances.push_back(&instance);
+        tile.m_staticWmoBounds.Add(instance.m_bounds);
+    }
+
+    tile.m_staticDoodadInstances.clear();
+    tile.m_staticDoodadBounds.Clear();
+    tile.m_staticDoodadBounds.Reserve(tile.m_staticDoodads.size());
+
+    for (auto const id : tile.m_staticDoodads)
+    {
+        auto const& instance = m_staticDoodads.at(id);
+
+        tile.m_staticDoodadInstances.push_back(&instance);
+        tile.m_staticDoodadBounds.Add(instance.m_bounds);
+    }
+}
+
+void Map::GetTileRange(const math::BoundingBox& bounds, int& minX, int& minY,
+                       int& maxX, int& maxY) const
+{
+    // this is the inverse of the tile coordinates used by GetTile()
+    float originX, originY;
+
+    if (HasADTs())
+        originX = originY = (MeshSettings::Adts / 2.f) * MeshSettings::AdtSize;
+    else
+    {
+        originX = m_globalWmoOriginX;
+        originY = m_globalWmoOriginY;
+    }
+
+    auto const cell = [](float distance)
+    { return static_cast<int>(std::floor(distance / MeshSettings::TileSize)); };
+
+    minX = cell(originY - bounds.MaxCorner.Y) - 1;
+    maxX = cell(originY - bounds.MinCorner.Y) + 1;
+    minY = cell(originX - bounds.MaxCorner.X) - 1;
+    maxY = cell(originX - bounds.MinCorner.X) + 1;
+}
+
 const Tile* Map::GetTile(float x, float y) const
 {
     // find the tile corresponding to this (x, y)
@@ -683,15 +1296,20 @@ bool Map::GetADTHeight(const Tile* tile, float x, float y, float& height,
 bool Map::FindNextZ(const Tile* tile, float x, float y, float zHint,
                     bool includeAdt, float& result) const
 {
-    result = zHint;
-
     // check BVH data for this tile
-    bool rayHit;
-
     math::Ray ray {{x, y, zHint}, {x, y, tile->m_bounds.getMinimum().Z}};
 
-    if ((rayHit = RayCast(ray, {tile}, true)))
-        result = ray.GetHitPoint().Z;
+    auto const rayHit = RayCast(ray, {tile}, true);
+
+    return ResolveNextZ(tile, x, y, zHint, rayHit, ray.GetHitPoint().Z,
+                        includeAdt, result);
+}
+
+bool Map::ResolveNextZ(const Tile* tile, float x, float y, float zHint,
+                       bool rayHit, float rayZ, bool includeAdt,
+                       float& result) const
+{
+    result = rayHit ? rayZ : zHint;
 
     // if we don't care about adts, we're done
     if (!includeAdt)
@@ -780,6 +1398,102 @@ bool Map::FindPointInBetweenVectors(const math::Vertex& start, const math::Verte
     return true;
 }
 
+bool Map::MoveAlongSurface(const math::Vertex& start, const math::Vertex& end,
+                           math::Vertex& result, math::Vector3& hitNormal,
+                           bool& blocked, bool slide) const
+{
+    constexpr float extents[] = {5.f, 5.f, 5.f};
+
+    float recastStart[3];
+    float recastEnd[3];
+
+    math::Convert::VertexToRecast(start, recastStart);
+    math::Convert::VertexToRecast(end, recastEnd);
+
+    dtPolyRef startRef;
+    float snappedStart[3];
+    if (!(m_navQuery.findNearestPoly(recastStart, extents, &m_queryFilter,
+                                     &startRef, snappedStart) &
+          DT_SUCCESS) ||
+        !startRef)
+        return false;
+
+    dtPolyRef polyRefBuffer[MaxPathHops];
+
+    dtRaycastHit hit;
+    hit.path = polyRefBuffer;
+    hit.maxPath = MaxPathHops;
+    hit.pathCount = 0;
+
+    if (!(m_navQuery.raycast(startRef, snappedStart, recastEnd,
+                             &m_queryFilter, 0, &hit) &
+          DT_SUCCESS) ||
+        !hit.pathCount)
+        return false;
+
+    blocked = hit.t != FLT_MAX;
+
+    dtPolyRef endRef = hit.path[hit.pathCount - 1];
+    float target[3];
+
+    if (blocked)
+    {
+        math::Convert::VertexToWow(hit.hitNormal, hitNormal);
+        dtVlerp(target, snappedStart, recastEnd, hit.t);
+    }
+    else
+    {
+        hitNormal = {0.f, 0.f, 0.f};
+        dtVcopy(target, recastEnd);
+    }
+
+    // the ray stops dead at the first wall.  to slide along it instead, the
+    // movement is constrained to the navmesh boundary by a local search
+    // toward the original end point
+    if (blocked && slide)
+    {
+        int visitedCount = 0;
+        if (!(m_navQuery.moveAlongSurface(startRef, snappedStart, recastEnd,
+                                          &m_queryFilter, target,
+                                          polyRefBuffer, &visitedCount,
+                                          MaxPathHops) &
+              DT_SUCCESS) ||
+            !visitedCount)
+            return false;
+
+        endRef = polyRefBuffer[visitedCount - 1];
+
+        // the slide may have cleared the first wall entirely, or ended
+        // against another.  continuing toward the end point from where it
+        // stopped tells which
+        hit.pathCount = 0;
+        if (!(m_navQuery.raycast(endRef, target, recastEnd, &m_queryFilter,
+                                 0, &hit) &
+              DT_SUCCESS))
+            return false;
+
+        blocked = hit.t != FLT_MAX;
+
+        if (blocked)
+            math::Convert::VertexToWow(hit.hitNormal, hitNormal);
+        else
+            hitNormal = {0.f, 0.f, 0.f};
+    }
+
+    // neither query adjusts the height of the point to the surface
+    float onPoly[3];
+    if (!(m_navQuery.closestPointOnPoly(endRef, target, onPoly, nullptr) &
+          DT_SUCCESS))
+        return false;
+
+    math::Convert::VertexToWow(onPoly, result);
+
+    // take the imprecise z value from the mesh, and refine it
+    CorrectHeights(&result, 1);
+
+    return true;
+}
+
 bool Map::FindRandomPointAroundCircle(const math::Vertex& centerPosition,
                                       const float radius,
                                       math::Vertex& randomPoint) const
@@ -797,6 +1511,8 @@ bool Map::FindRandomPointAroundCircle(const math::Vertex& centerPosition,
 
     float outputPoint[3];
 
+    t_random = &m_random;
+
     dtPolyRef randomRef;
     if (m_navQuery.findRandomPointAroundCircle(startRef,
                                                recastCenter,
@@ -813,6 +1529,48 @@ bool Map::FindRandomPointAroundCircle(const math::Vertex& centerPosition,
     return true;
 }
 
+bool Map::FindRandomPointsAroundCircle(
+    const math::Vertex& centerPosition, float radius, unsigned int count,
+    std::vector<math::Vertex>& randomPoints) const
+{
+    float recastCenter[3];
+    math::Convert::VertexToRecast(centerPosition, recastCenter);
+
+    constexpr float extents[] = {1.f, 1.f, 1.f};
+
+    // the start poly is shared by every sample
+    dtPolyRef startRef;
+    if (m_navQuery.findNearestPoly(recastCenter, extents, &m_queryFilter,
+                                   &startRef, nullptr) != DT_SUCCESS)
+        return false;
+
+    t_random = &m_random;
+
+    randomPoints.clear();
+    randomPoints.reserve(count);
+
+    for (auto i = 0u; i < count; ++i)
+    {
+        float outputPoint[3];
+        dtPolyRef randomRef;
+
+        if (m_navQuery.findRandomPointAroundCircle(
+                startRef, recastCenter, radius, &m_queryFilter,
+                &random_between_0_and_1, &randomRef,
+                outputPoint) != DT_SUCCESS)
+            continue;
+
+        randomPoints.emplace_back();
+        math::Convert::VertexToWow(outputPoint, randomPoints.back());
+    }
+
+    return !randomPoints.empty();
+}
+
+void Map::SeedRandom(std::uint64_t seed)
+{
+    m_random.Seed(seed);
+}
 
 bool Map::FindHeight(const math::Vertex& source, float x, float y, float& z) const
 {
@@ -943,11 +1701,120 @@ bool Map::ZoneAndArea(const math::Vertex& position, unsigned int& zone,
     return rayResult || adtResult;
 }
 
-bool Map::LineOfSight(const math::Vertex& start, const math::Vertex& stop, bool doodads) const
+bool Map::NavMeshLineOfSight(const math::Vertex& start,
+                             const math::Vertex& stop) const
 {
+    if (start.GetDistance(stop) > MaxNavMeshSightDistance)
+        return false;
+
+    // a tile being rebuilt in the background already holds its new
+    // obstacles, but the navmesh does not until the new mesh is swapped in
+    if (!m_tileRebuilds.empty())
+    {
+        math::BoundingBox bounds {start, start};
+        bounds.update(stop);
+
+        for (auto const& entry : m_tileRebuilds)
+            if (entry.second.tile->m_bounds.intersect2d(bounds))
+                return false;
+    }
+
+    // both positions must be at the feet of a unit standing on the navmesh
+    constexpr float extents[] = {1.f, MeshSettings::WalkableClimb, 1.f};
+
+    float recastStart[3];
+    float recastStop[3];
+
+    math::Convert::VertexToRecast(start, recastStart);
+    math::Convert::VertexToRecast(stop, recastStop);
+
+    dtPolyRef startRef, stopRef;
+    if (!(m_navQuery.findNearestPoly(recastStart, extents, &m_queryFilter,
+                                     &startRef, nullptr) &
+          DT_SUCCESS) ||
+        !startRef ||
+        !(m_navQuery.findNearestPoly(recastStop, extents, &m_queryFilter,
+                                     &stopRef, nullptr) &
+          DT_SUCCESS) ||
+        !stopRef)
+        return false;
+
+    dtPolyRef corridor[MaxStackedPolys];
+    int corridorSize = 0;
+
+    float snappedStart[3], snappedStop[3];
+    if (!IsDirectlyWalkable(startRef, recastStart, stopRef, recastStop,
+                            corridor, MaxStackedPolys, snappedStart,
+                            snappedStop, &corridorSize))
+        return false;
+
+    // the navmesh guarantees room for an agent above every poly.  so long as
+    // the sight line stays within that space, nothing can block it.  if it
+    // dips below the ground or rises above the agent, the collision geometry
+    // must decide
+    auto const samples = static_cast<int>(
+        std::ceil(start.GetDistance(stop) / MeshSettings::CellSize));
+
+    int current = 0;
+    for (auto i = 0; i <= samples; ++i)
+    {
+        auto const t = samples ? static_cast<float>(i) / samples : 0.f;
+
+        float sample[3];
+        dtVlerp(sample, recastStart, recastStop, t);
+
+        auto const lineHeight = sample[1];
+
+        if (!SnapHeight(corridor, corridorSize, current, sample))
+            return false;
+
+        if (lineHeight < sample[1] - MeshSettings::DetailSampleMaxError ||
+            lineHeight > sample[1] + MeshSettings::WalkableHeight)
+            return false;
+    }
+
+    return true;
+}
+
+bool Map::LineOfSight(const math::Vertex& start, const math::Vertex& stop,
+                      bool doodads, bool navMeshFirst) const
+{
+    bool result;
+
+    if (m_lineOfSightCache)
+    {
+        if (m_lineOfSightCache->Get(start, stop, doodads, navMeshFirst,
+                                    result))
+        {
+            ++m_statistics.lineOfSightCacheHits;
+            return result;
+        }
+
+        ++m_statistics.lineOfSightCacheMisses;
+    }
+
+    ++m_statistics.lineOfSightQueries;
+
+    if (navMeshFirst && NavMeshLineOfSight(start, stop))
+    {
+        ++m_statistics.navMeshLineOfSights;
+
+        if (m_lineOfSightCache)
+            m_lineOfSightCache->Insert(start, stop, doodads, navMeshFirst,
+                                       true);
+
+        return true;
+    }
+
     math::Ray ray {start, stop};
     // RayCast() returns true when an obstacle is hit
-    return !RayCast(ray, doodads);
+    result = !RayCast(ray, doodads);
+
+    if (m_lineOfSightCache)
+        m_lineOfSightCache->Insert(start, stop, doodads, navMeshFirst,
+                                   result);
+
+    return result;
 }
 
 bool Map::RayCast(math::Ray& ray, bool doodads) const
@@ -977,6 +1844,9 @@ bool Map::RayCast(math::Ray& ray, const std::vector<const Tile*>& tiles,
     std::unordered_set<std::uint32_t> staticWmos, staticDoodads;
     std::unordered_set<std::uint64_t> temporaryWmos, temporaryDoodads;
 
+    // indices of the instances on a tile whose bounds the ray reaches
+    std::vector<std::uint32_t> candidates;
+
     // for each tile...
     for (auto const tile : tiles)
     {
@@ -984,9 +1854,16 @@ bool Map::RayCast(math::Ray& ray, const std::vector<const Tile*>& tiles,
         if (!ray.IntersectBoundingBox(tile->m_bounds))
             continue;
 
-        // measure intersection for all static wmos on the tile
-        for (auto const& id : tile->m_staticWmos)
+        // skip wmos whose bbox doesn't intersect, saves us from calculating
+        // the inverse ray
+        candidates.clear();
+        tile->m_staticWmoBounds.Intersect(ray, candidates);
+
+        // measure intersection for the remaining static wmos on the tile
+        for (auto const index : candidates)
         {
+            auto const id = tile->m_staticWmos[index];
+
             // skip static wmos we have already seen (possibly from a previous
             // tile)
             if (staticWmos.find(id) != staticWmos.end())
@@ -995,20 +1872,16 @@ bool Map::RayCast(math::Ray& ray, const std::vector<const Tile*>& tiles,
             // record this static wmo as having been tested
             staticWmos.insert(id);
 
-            auto const& instance = m_staticWmos.at(id);
-
-            // skip this wmo if the bbox doesn't intersect, saves us from
-            // calculating the inverse ray
-            if (!ray.IntersectBoundingBox(instance.m_bounds))
-                continue;
+            auto const& instance = *tile->m_staticWmoInstances[index];
 
             math::Ray rayInverse(math::Vector3::Transform(
                                      start, instance.m_inverseTransformMatrix),
                                  math::Vector3::Transform(
                                      end, instance.m_inverseTransformMatrix));
 
-            // if this is a closer hit, update the original ray's distance
-            if (auto model = instance.m_model.lock())
+            // if this is a closer hit, update the original ray's distance.
+            // the model is loaded now if this is the first ray to reach it
+            if (auto model = GetStaticWmoModel(*tile, index))
             {
                 if (model->m_aabbTree.IntersectRay(rayInverse) &&
                     rayInverse.GetDistance() < ray.GetDistance())
@@ -1017,11 +1890,20 @@ bool Map::RayCast(math::Ray& ray, const std::vector<const Tile*>& tiles,
                     ray.SetHitPoint(rayInverse.GetDistance());
 
                     if (area)
-                        *area = model->m_nameSetToAreaZone[instance.m_nameSet]
-                                    .first;
+                        *area = model->AreaAndZone(instance.m_nameSet).first;
                     if (zone)
-                        *zone = model->m_nameSetToAreaZone[instance.m_nameSet]
-                                    .second;
+                        *zone = model->AreaAndZone(instance.m_nameSet).second;
+                }
+
+                // the doodads of the wmo's set are loaded by the first ray
+                // which tests doodads and reaches it
+                if (doodads)
+                {
+                    auto const doodadSet = GetStaticWmoDoodadSet(*tile, index);
+
+                    if (doodadSet &&
+                        IntersectDoodadSet(*doodadSet, rayInverse, ray))
+                        hit = true;
                 }
             }
         }
@@ -1029,8 +1911,13 @@ bool Map::RayCast(math::Ray& ray, const std::vector<const Tile*>& tiles,
         // measure intersection for all static doodads on this tile
         if (doodads)
         {
-            for (auto const& id : tile->m_staticDoodads)
+            candidates.clear();
+            tile->m_staticDoodadBounds.Intersect(ray, candidates);
+
+            for (auto const index : candidates)
             {
+                auto const id = tile->m_staticDoodads[index];
+
                 // skip static doodads we have already seen (possibly from a
                 // previous tile)
                 if (staticDoodads.find(id) != staticDoodads.end())
@@ -1039,12 +1926,7 @@ bool Map::RayCast(math::Ray& ray, const std::vector<const Tile*>& tiles,
                 // record this static doodad as having been tested
                 staticDoodads.insert(id);
 
-                auto const& instance = m_staticDoodads.at(id);
-
-                // skip this doodad if the bbox doesn't intersect, saves us from
-                // calculating the inverse ray
-                if (!ray.IntersectBoundingBox(instance.m_bounds))
-                    continue;
+                auto const& instance = *tile->m_staticDoodadInstances[index];
 
                 math::Ray rayInverse(
                     math::Vector3::Transform(start,
@@ -1053,8 +1935,8 @@ bool Map::RayCast(math::Ray& ray, const std::vector<const Tile*>& tiles,
                         end, instance.m_inverseTransformMatrix));
 
                 // if this is a closer hit, update the original ray's distance
-                if (instance.m_model.lock()->m_aabbTree.IntersectRay(
-                        rayInverse) &&
+                if (GetStaticDoodadModel(*tile, index)
+                        ->m_aabbTree.IntersectRay(rayInverse) &&
                     rayInverse.GetDistance() < ray.GetDistance())
                 {
                     hit = true;
@@ -1101,14 +1983,10 @@ bool Map::RayCast(math::Ray& ray, const std::vector<const Tile*>& tiles,
                         ray.SetHitPoint(rayInverse.GetDistance());
                         if (area)
                             *area =
-                                model
-                                    ->m_nameSetToAreaZone[wmo.second->m_nameSet]
-                                    .first;
+                                model->AreaAndZone(wmo.second->m_nameSet).first;
                         if (zone)
-                            *zone =
-                                model
-                                    ->m_nameSetToAreaZone[wmo.second->m_nameSet]
-                                    .second;
+                            *zone = model->AreaAndZone(wmo.second->m_nameSet)
+                                        .second;
                     }
                 }
             }
@@ -1153,4 +2031,138 @@ bool Map::RayCast(math::Ray& ray, const std::vector<const Tile*>& tiles,
 
     return hit;
 }
+
+void Map::RayCast(const Tile* tile, math::Ray* rays, std::size_t count,
+                  bool* hits) const
+{
+    for (auto i = 0u; i < count; ++i)
+        hits[i] = false;
+
+    // an instance index paired with the index of a ray which reaches it
+    using Candidate = std::pair<std::uint32_t, std::uint32_t>;
+
+    // within a single tile each instance appears once, so unlike the above
+    // there is no need to track which instances have already been tested.
+    // each model is visited once for the whole batch of rays, and is only
+    // fetched, and possibly loaded, if some ray reaches its bounds
+    auto const test = [rays, hits](const math::Matrix& inverse,
+                                   auto const& getModel, const Candidate* begin,
+                                   const Candidate* end)
+    {
+        if (begin == end)
+            return;
+
+        auto const model = getModel();
+
+        if (!model)
+            return;
+
+        for (auto c = begin; c != end; ++c)
+        {
+            auto& ray = rays[c->second];
+
+            math::Ray rayInverse(
+                math::Vector3::Transform(ray.GetStartPoint(), inverse),
+                math::Vector3::Transform(ray.GetEndPoint(), inverse));
+
+            if (model->m_aabbTree.IntersectRay(rayInverse) &&
+                rayInverse.GetDistance() < ray.GetDistance())
+            {
+                hits[c->second] = true;
+                ray.SetHitPoint(rayInverse.GetDistance());
+            }
+        }
+    };
+
+    std::vector<std::uint32_t> indices;
+    std::vector<Candidate> candidates;
+
+    // cull every ray against the bounds of all static instances of one kind,
+    // then visit the instances in order with the rays which reached each
+    auto const testStatic = [&](const math::BoundingBoxArray& bounds,
+                                auto const& getInstance, auto const& getModel)
+    {
+        candidates.clear();
+
+        for (auto i = 0u; i < count; ++i)
+        {
+            indices.clear();
+            bounds.Intersect(rays[i], indices);
+
+            for (auto const index : indices)
+                candidates.push_back({index, i});
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+
+        for (auto begin = 0u; begin < candidates.size();)
+        {
+            auto const index = candidates[begin].first;
+
+            auto end = begin;
+            while (end < candidates.size() && candidates[end].first == index)
+                ++end;
+
+            test(getInstance(index).m_inverseTransformMatrix,
+                 [&getModel, index]() { return getModel(index); },
+                 candidates.data() + begin, candidates.data() + end);
+
+            begin = end;
+        }
+    };
+
+    testStatic(
+        tile->m_staticWmoBounds,
+        [tile](std::uint32_t i) -> const WmoInstance&
+        { return *tile->m_staticWmoInstances[i]; },
+        [this, tile](std::uint32_t i) { return GetStaticWmoModel(*tile, i); });
+
+    // the candidates left by the wmo pass are each ray which reached each
+    // wmo, and those rays are also tested against the wmo's doodad set
+    for (auto const& candidate : candidates)
+    {
+        auto const doodadSet = GetStaticWmoDoodadSet(*tile, candidate.first);
+
+        if (!doodadSet)
+            continue;
+
+        auto const& instance = *tile->m_staticWmoInstances[candidate.first];
+        auto const& inverse = instance.m_inverseTransformMatrix;
+        auto& ray = rays[candidate.second];
+
+        const math::Ray rayInverse(
+            math::Vector3::Transform(ray.GetStartPoint(), inverse),
+            math::Vector3::Transform(ray.GetEndPoint(), inverse));
+
+        if (IntersectDoodadSet(*doodadSet, rayInverse, ray))
+            hits[candidate.second] = true;
+    }
+
+    testStatic(
+        tile->m_staticDoodadBounds,
+        [tile](std::uint32_t i) -> const DoodadInstance&
+        { return *tile->m_staticDoodadInstances[i]; },
+        [this, tile](std::uint32_t i)
+        { return GetStaticDoodadModel(*tile, i); });
+
+    // temporary obstacles come and go, and are tested one at a time
+    auto const testTemporary = [&](const auto& instance)
+    {
+        candidates.clear();
+
+        for (auto i = 0u; i < count; ++i)
+            if (rays[i].IntersectBoundingBox(instance.m_bounds))
+                candidates.push_back({0, i});
+
+        test(instance.m_inverseTransformMatrix,
+             [&instance]() { return instance.m_model.lock(); },
+             candidates.data(), candidates.data() + candidates.size());
+    };
+
+    for (auto const& wmo : tile->m_temporaryWmos)
+        testTemporary(*wmo.second);
+
+    for (auto const& doodad : tile->m_temporaryDoodads)
+        testTemporary(*doodad.second);
+}
 } // namespace pathfind
@@ -2,17 +2,30 @@
 
 #include "BVH.hpp"
 #include "Common.hpp"
+#include "FlowField.hpp"
+#include "LineOfSightCache.hpp"
 #include "Model.hpp"
+#include "PathCache.hpp"
+#include "PathOracle.hpp"
 #include "Tile.hpp"
 #include "recastnavigation/Detour/Include/DetourNavMesh.h"
 #include "recastnavigation/Detour/Include/DetourNavMeshQuery.h"
+#include "utility/Random.hpp"
 #include "utility/Ray.hpp"
 #include "utility/Vector.hpp"
+#include "utility/WorkerPool.hpp"
 
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
 #include <filesystem>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace std
@@ -29,6 +42,40 @@ struct hash<std::pair<int, int>>
 
 namespace pathfind
 {
+// counters for the queries made against a map, for profiling
+struct QueryStatistics
+{
+    std::uint64_t pathQueries = 0;
+    // path queries answered with a straight line along the navmesh, with no
+    // search required
+    std::uint64_t directPaths = 0;
+    // path queries whose corridor was read from a flow field
+    std::uint64_t flowFieldHits = 0;
+    // path queries for which the path cache was consulted, and found or did
+    // not find a valid corridor
+    std::uint64_t pathCacheHits = 0;
+    std::uint64_t pathCacheMisses = 0;
+    // as above, for line of sight checks
+    std::uint64_t lineOfSightCacheHits = 0;
+    std::uint64_t lineOfSightCacheMisses = 0;
+    // line of sight checks not answered by the cache, and of those, the
+    // checks answered by the navmesh alone
+    std::uint64_t lineOfSightQueries = 0;
+    std::uint64_t navMeshLineOfSights = 0;
+};
+
+// a poly reachable from some origin, with the walking distance to the point
+// at which it is entered, and that point
+struct ReachablePoly
+{
+    dtPolyRef poly;
+    float distance;
+    math::Vertex entry;
+};
+
+// sorted by poly ref
+using PolyDistances = std::vector<ReachablePoly>;
+
 // note that instances of this type are assumed to be thread-local, therefore
 // the type is not thread safe
 class Map
@@ -38,6 +85,9 @@ class Map
 private:
     static constexpr int MaxStackedPolys = 128;
     static constexpr int MaxPathHops = 4096;
+    // beyond this, a line of sight check is too likely to be ambiguous to be
+    // worth trying on the navmesh first
+    static constexpr float MaxNavMeshSightDistance = 40.f;
 
     BVH m_bvhLoader;
 
@@ -57,40 +107,168 @@ private:
     dtNavMeshQuery m_navQuery;
     dtQueryFilter m_queryFilter;
 
+    // shortest path trees toward popular targets, indexed by target poly.
+    // this must be declared before m_tiles, because tiles notify the map as
+    // they are destroyed
+    std::unordered_map<dtPolyRef, std::unique_ptr<FlowField>> m_flowFields;
+
+    // optional all pairs next hop table, only for small global wmo maps
+    std::unique_ptr<PathOracle> m_pathOracle;
+
+    // optional cache of recently searched corridors.  like m_flowFields, this
+    // must be declared before m_tiles
+    std::unique_ptr<PathCache> m_pathCache;
+
+    // optional cache of recent line of sight results
+    std::unique_ptr<LineOfSightCache> m_lineOfSightCache;
+
+    mutable QueryStatistics m_statistics;
+
+    // source of randomness for all random point queries on this map
+    mutable utility::Random m_random;
+
+    // scratch space for searches over the poly graph, kept to avoid
+    // reallocating it for every query
+    mutable PolyGraph::NodeMap m_searchNodes;
+
     // TODO: Does this need to be a pointer?
     std::unordered_map<std::pair<int, int>, std::unique_ptr<Tile>> m_tiles;
 
-    // indexed by unique instance id.  this data is always loaded.  whenever a
-    // tile using one of these instances is loaded, the corresponding model is
-    // loaded also.  whenever all tiles referencing a model (possibly through
-    // distinct instances) are unloaded, the model is unloaded.
+    // indexed by unique instance id.  this data is always loaded.  the model
+    // of an instance is not loaded with the tiles using it, but by the first
+    // ray to reach the instance on one of them (or by WarmUpModels()).  the
+    // tile then keeps it, and whenever all tiles holding a model (possibly
+    // through distinct instances) are unloaded, the model is unloaded.
     std::unordered_map<std::uint32_t, WmoInstance> m_staticWmos;
     std::unordered_map<std::uint32_t, DoodadInstance> m_staticDoodads;
 
-    // indexed by GUID
+    // the models this map has obtained from the repository, indexed by the id
+    // the bvh index assigned them, so that a repeated lookup is a single load
+    mutable std::vector<std::weak_ptr<const WmoModel>> m_wmoModels;
+    mutable std::vector<std::weak_ptr<const DoodadModel>> m_doodadModels;
+
+    // indexed by GUID.  temporary doodads are owned by the loaded tiles they
+    // overlap, and live for as long as any of those tiles remains loaded
     std::unordered_map<std::uint64_t, std::weak_ptr<WmoInstance>>
         m_temporaryWmos;
     std::unordered_map<std::uint64_t, std::weak_ptr<DoodadInstance>>
         m_temporaryDoodads;
 
-    // map, by filename, of loaded models
-    std::unordered_map<std::string, std::weak_ptr<WmoModel>> m_loadedWmoModels;
-    std::unordered_map<std::string, std::weak_ptr<DoodadModel>>
-        m_loadedDoodadModels;
+    // the GUIDs of the live temporary doodads which may overlap each tile, by
+    // tile coordinates, whether or not the tile is loaded.  a tile loaded
+    // while one of them is still held by another tile receives it also
+    std::unordered_map<std::pair<int, int>, std::vector<std::uint64_t>>
+        m_temporaryObstacleTiles;
+
+    // forgets the temporary doodads which are no longer held by any tile,
+    // along with their entries in the tile registry
+    void PruneTemporaryObstacles();
 
     // ensures that the model for a particular WMO instance is loaded
-    std::shared_ptr<WmoModel> LoadModelForWmoInstance(unsigned int instanceId);
+    std::shared_ptr<const WmoModel>
+    LoadModelForWmoInstance(unsigned int instanceId) const;
 
     // ensures that the model for a particular doodad instance is loaded
-    std::shared_ptr<DoodadModel>
-    LoadModelForDoodadInstance(unsigned int instanceId);
+    std::shared_ptr<const DoodadModel>
+    LoadModelForDoodadInstance(unsigned int instanceId) const;
 
-    // ensure that the given WMO model is loaded
-    std::shared_ptr<WmoModel> EnsureWmoModelLoaded(const std::string& mpq_path);
+    // ensure that the given WMO model is loaded.  models are shared by every
+    // map in the process through the ModelRepository
+    std::shared_ptr<const WmoModel> EnsureWmoModelLoaded(ModelId id) const;
 
     // ensure that the given doodad model is loaded
-    std::shared_ptr<DoodadModel>
-    EnsureDoodadModelLoaded(const std::string& mpq_path);
+    std::shared_ptr<const DoodadModel>
+    EnsureDoodadModelLoaded(ModelId id) const;
+
+    // ensure that the given doodad set of a WMO model is loaded.  returns
+    // nullptr if the model has no such set
+    std::shared_ptr<const DoodadSet>
+    EnsureDoodadSetLoaded(const WmoModel& model, unsigned int set) const;
+
+    // the model of the static instance at the given index of the tile.  tiles
+    // do not load their models up front, so the first ray to reach an
+    // instance loads it here, and the tile keeps it until it is unloaded
+    std::shared_ptr<const WmoModel> GetStaticWmoModel(const Tile& tile,
+                                                      std::size_t index) const;
+    std::shared_ptr<const DoodadModel>
+    GetStaticDoodadModel(const Tile& tile, std::size_t index) const;
+
+    // the doodad set of the static wmo instance at the given index of the
+    // tile.  only ray casts which test doodads need it, so it is loaded
+    // separately from the model, by the first of those to reach the instance
+    std::shared_ptr<const DoodadSet>
+    GetStaticWmoDoodadSet(const Tile& tile, std::size_t index) const;
+
+    // fills in the static instances of a newly loaded tile, and their bounds
+    void IndexStaticInstances(Tile& tile) const;
+
+    // the range of tile coordinates which the given bounds may overlap.  a
+    // tile extends somewhat beyond its cell of the grid, so the range also
+    // includes the tiles surrounding those cells
+    void GetTileRange(const math::BoundingBox& bounds, int& minX, int& minY,
+                      int& maxX, int& maxY) const;
+
+    // rasterizes into a newly loaded tile the temporary obstacles which
+    // overlap it.  returns true if there were any, and the tile must be
+    // rebuilt
+    bool AddTemporaryObstacles(Tile& tile);
+
+    // while a game object batch is open, obstacles are only rasterized into
+    // the tiles they overlap, and the coordinates of those tiles recorded
+    // here to be rebuilt when it is committed
+    bool m_gameObjectBatch;
+    std::unordered_set<std::pair<int, int>> m_dirtyTiles;
+
+    // rebuilds the meshes of the given tiles from their height fields, in
+    // parallel, and swaps them into the navmesh
+    void RebuildTiles(const std::vector<Tile*>& tiles);
+
+    // a tile changed by temporary obstacles, whose mesh is rebuilt in the
+    // background while the old mesh continues to serve queries.  the entries
+    // are only added and removed by this thread, but their contents are
+    // shared with the builds and guarded by m_tileRebuildMutex
+    struct TileRebuild
+    {
+        Tile* tile;
+
+        // obstacles not yet rasterized.  a running build takes those added
+        // in the meantime once it finishes, and builds again
+        std::vector<std::shared_ptr<const DoodadInstance>> pending;
+
+        // true from when a build is submitted until it finds nothing pending
+        bool building = false;
+
+        // the newest mesh built, waiting for Update() to swap it in
+        bool built = false;
+        std::vector<std::uint8_t> mesh;
+
+        // the first error from a build since the last Update()
+        std::exception_ptr error;
+    };
+
+    bool m_backgroundRebuilds;
+    std::function<void(int, int)> m_tileRebuiltCallback;
+
+    // by tile coordinates
+    std::unordered_map<std::pair<int, int>, TileRebuild> m_tileRebuilds;
+    std::mutex m_tileRebuildMutex;
+    std::condition_variable m_tileRebuildDone;
+
+    // created when background rebuilds are first enabled.  declared after
+    // the tiles and the rebuild state, so that any running builds finish
+    // before what they use is destroyed
+    std::unique_ptr<utility::WorkerPool> m_rebuildPool;
+
+    // queues an obstacle for the background rebuild of a tile, and submits
+    // a build to the pool unless one is already running for it
+    void QueueTileRebuild(const std::pair<int, int>& coords, Tile& tile,
+                          std::shared_ptr<const DoodadInstance> obstacle);
+
+    // run by the pool.  builds until nothing is pending for the tile
+    void BuildTile(TileRebuild& rebuild);
+
+    // waits for any build of the given tile, and discards it
+    void CancelTileRebuild(const std::pair<int, int>& coords);
 
     const Tile* GetTile(float x, float y) const;
 
@@ -102,10 +280,53 @@ private:
     bool FindNextZ(const Tile* tile, float x, float y, float zHint,
                       bool includeAdt, float& result) const;
 
+    // the second half of FindNextZ(), which chooses between the result of the
+    // downward ray cast and the adt height
+    bool ResolveNextZ(const Tile* tile, float x, float y, float zHint,
+                      bool rayHit, float rayZ, bool includeAdt,
+                      float& result) const;
+
+    // FindPath(), optionally also returning the poly containing each point
+    bool FindStraightPath(const math::Vertex& start, const math::Vertex& end,
+                          std::vector<math::Vertex>& output, bool allowPartial,
+                          std::vector<dtPolyRef>* polyRefs) const;
+
+    // true if a ray along the navmesh from 'start' reaches 'end' within the
+    // end poly, without hitting a wall.  the closest points to each position
+    // on their respective polys are written to 'snappedStart' and
+    // 'snappedEnd', and the number of polys crossed to 'corridorSize'.
+    // positions are in recast coordinates
+    bool IsDirectlyWalkable(dtPolyRef startRef, const float* start,
+                            dtPolyRef endRef, const float* end,
+                            dtPolyRef* buffer, int bufferSize,
+                            float* snappedStart, float* snappedEnd,
+                            int* corridorSize = nullptr) const;
+
+    // sets the height of 'position' to that of the navmesh, by searching
+    // 'corridor' for the containing poly, starting at index 'current'.  on
+    // success, 'current' is advanced to the containing poly
+    bool SnapHeight(const dtPolyRef* corridor, int corridorSize, int& current,
+                    float* position) const;
+
+    // true if the sight line between two nearby units standing on the
+    // navmesh is proven clear by the navmesh alone.  false means only that
+    // the collision geometry must be consulted, as it must when the segment
+    // crosses a tile whose new obstacles are not yet in the navmesh
+    bool NavMeshLineOfSight(const math::Vertex& start,
+                            const math::Vertex& stop) const;
+
+    // called before the polys of a tile are removed from the navmesh, either
+    // because the tile is unloaded or because it is being rebuilt
+    void OnTileChanged(const Tile& tile);
+
     bool RayCast(math::Ray& ray, bool doodads) const;
     bool RayCast(math::Ray& ray, const std::vector<const Tile*>& tiles,
                  bool doodads, unsigned int* zone = nullptr,
                  unsigned int* area = nullptr) const;
+    // casts many rays against the models of a single tile, including doodads
+    // and temporary obstacles
+    void RayCast(const Tile* tile, math::Ray* rays, std::size_t count,
+                 bool* hits) const;
 
     // TODO: need mechanism to cleanup expired weak pointers saved in the
     // containers of this class
@@ -122,7 +343,9 @@ public:
     void UnloadADT(int x, int y);
     int LoadAllADTs();
 
-    // rotation specified in radians rotated around Z axis
+    // rotation specified in radians rotated around Z axis.  the obstacle is
+    // kept by the loaded tiles it overlaps, and is discarded once they have
+    // all been unloaded.  one which overlaps no loaded tile is not kept
     void AddGameObject(std::uint64_t guid, unsigned int displayId,
                        const math::Vertex& position, float orientation,
                        int doodadSet = -1);
@@ -133,12 +356,131 @@ public:
                        const math::Vertex& position,
                        const math::Matrix& rotation, int doodadSet = -1);
 
-    std::shared_ptr<Model> GetOrLoadModelByDisplayId(unsigned int displayId);
+    // game objects added between these calls rebuild the tiles they overlap
+    // once, on commit, rather than once per object.  the tiles are rebuilt
+    // in parallel
+    void BeginGameObjectBatch();
+    void CommitGameObjectBatch();
+
+    // when enabled, the tiles changed by game objects are rebuilt on a pool
+    // of background threads, starting as soon as each object is added.  the
+    // old meshes continue to serve queries until Update() swaps the new ones
+    // in.  ray casts and line of sight see the objects at once, and the
+    // navmesh is not consulted for line of sight across a tile until its
+    // new mesh is in.  disabling waits for any rebuilds
+    void SetBackgroundTileRebuilds(bool enable);
+
+    // called by Update() with the coordinates of each tile whose new mesh
+    // has been swapped into the navmesh
+    void SetTileRebuiltCallback(std::function<void(int, int)> callback);
+
+    // swaps in the meshes of any finished background rebuilds, and makes
+    // the callback for each.  returns the number of tiles swapped in.  should
+    // a build have failed, that tile keeps its old mesh and the error is
+    // thrown, but only after the other tiles have been swapped in and the
+    // callback made for them
+    std::size_t Update();
+
+    // blocks until every background rebuild has been swapped in
+    void WaitForTileRebuilds();
+
+    std::shared_ptr<const Model>
+    GetOrLoadModelByDisplayId(unsigned int displayId);
+
+    // static models are otherwise loaded by the first query to reach them.
+    // for hotspots where the latency of that first query matters, this loads
+    // the models of every instance on a loaded tile within 'radius' of
+    // 'center' now.  returns the number of models loaded
+    int WarmUpModels(const math::Vertex& center, float radius);
 
     bool FindPath(const math::Vertex& start, const math::Vertex& end,
                   std::vector<math::Vertex>& output,
                   bool allowPartial = false) const;
 
+    // walking distance from 'start' to 'end', without producing the path
+    // itself.  the search is abandoned as soon as it is clear the distance
+    // exceeds 'maxDistance', in which case false is returned.  the distance is
+    // measured through the midpoints of the edges crossed, so it may slightly
+    // overestimate that of the path returned by FindPath
+    bool PathDistance(const math::Vertex& start, const math::Vertex& end,
+                      float maxDistance, float& distance) const;
+    // as above, for many end points at once, and with the same result for
+    // each.  distances to end points which are not within 'maxDistance' are
+    // set to infinity
+    bool PathDistances(const math::Vertex& start,
+                       const std::vector<math::Vertex>& ends,
+                       float maxDistance, std::vector<float>& distances) const;
+
+    // every poly which can be reached from 'center' by walking no more than
+    // 'radius', along with the distance to the point at which it is entered.
+    // this is intended to be computed once and then tested against many
+    // positions with DistancesFromPolySet()
+    bool PolysWithinPathDistance(const math::Vertex& center, float radius,
+                                 PolyDistances& result) const;
+    // snaps each position to the navmesh and looks up its poly in the set.
+    // the distance is that to the poly's entry point, plus that from there
+    // to the position.  positions on polys outside of the set, or further
+    // than 'radius' in total, are given infinite distance
+    void DistancesFromPolySet(const PolyDistances& polys, float radius,
+                              const std::vector<math::Vertex>& positions,
+                              std::vector<float>& distances) const;
+
+    // as FindPath(), but with the height of every point corrected against the
+    // collision geometry, as FindHeight() would do for each point in turn
+    bool FindPathWithPreciseHeights(const math::Vertex& start,
+                                    const math::Vertex& end,
+                                    std::vector<math::Vertex>& output,
+                                    bool allowPartial = false) const;
+
+    // corrects the height of each point against the collision geometry.  the
+    // existing heights are used as the starting point of a downward search,
+    // so the points must already lie on or slightly above the navmesh.
+    // points are grouped by tile, so that the models of each tile are visited
+    // once for the whole batch
+    void CorrectHeights(math::Vertex* points, std::size_t count) const;
+
+    // cuts the given path into points 'step' apart, each at the height of the
+    // navmesh.  the navmesh is walked once per segment, and the points are
+    // appended to 'output', so that several paths may be resampled into the
+    // same buffer.  if 'precise' is set, the heights are also refined against
+    // the collision geometry with CorrectHeights()
+    bool ResamplePath(const std::vector<math::Vertex>& path, float step,
+                      std::vector<math::Vertex>& output,
+                      bool precise = false) const;
+
+    // removes each point of the path whose neighbours are joined by a clear
+    // line along the navmesh, so long as the removed points lie within
+    // 'heightTolerance' of the height of that line.  this is intended for
+    // paths from FindPath, which often contain nearly collinear points where
+    // they cross tile boundaries
+    bool SimplifyPath(std::vector<math::Vertex>& path,
+                      float heightTolerance) const;
+
+    // build a shortest path tree toward the given target, covering every poly
+    // reachable for no more than 'maxCost'.  while the field exists, FindPath
+    // requests ending in the target's poly read their corridor from it rather
+    // than searching.  fields are cached by target poly, and are discarded
+    // when a tile they cover is unloaded or rebuilt for a temporary obstacle.
+    bool BuildFlowField(const math::Vertex& target, float maxCost);
+    void ClearFlowFields();
+
+    // precompute the next hop between every pair of polys for a global wmo
+    // map with no more than 'maxPolys' polys, and save it alongside the nav
+    // data.  when present, it is loaded with the map and FindPath follows it
+    // instead of searching.  returns false if the map is not eligible
+    bool BuildPathOracle(
+        unsigned int maxPolys = PathOracle::DefaultMaxPolys);
+    bool HasPathOracle() const;
+
+    // keep the corridors of up to 'capacity' recent path searches, keyed by
+    // start and end poly, so that repeated requests between the same polys
+    // need no search.  entries are invalidated when a tile they cross is
+    // unloaded or rebuilt, and the cache is cleared when an adt is loaded,
+    // since new tiles may open shorter routes.  zero, the default, disables
+    // the cache
+    void SetPathCacheCapacity(std::size_t capacity);
+    void ClearPathCache();
+
     // for finding height(s) at a given (x, y), there are two scenarios:
     // 1: we want to find exactly one z for a given path which has this (x, y)
     // as a hop.  in this case, there should only be one correct value,
@@ -159,18 +501,56 @@ public:
     // Returns true when there is line of sight from the start position to
     // the stop position.  The intended use of this is for spells and NPC
     // aggro, so doodads and temporary obstacles will be ignored.
+    // If navMeshFirst is set, checks between the feet of nearby units are
+    // first attempted with a ray cast along the navmesh, which is much
+    // cheaper when it succeeds, falling back to the collision geometry when
+    // the navmesh cannot decide.
     bool LineOfSight(const math::Vertex& start, const math::Vertex& stop,
-                     bool doodads) const;
+                     bool doodads, bool navMeshFirst = false) const;
+
+    // keep up to 'capacity' recent line of sight results, with endpoints
+    // matched to within LineOfSightCache::Quantum, for LineOfSight() to
+    // consult first.  entries are invalidated when a game object is added
+    // near the segment or a navmesh tile under it is replaced, and the cache
+    // is cleared when an adt is loaded or unloaded.  results which the
+    // navmesh was allowed to answer are kept apart from those it was not.
+    // zero, the default, disables the cache
+    void SetLineOfSightCacheCapacity(std::size_t capacity);
+    void ClearLineOfSightCache();
 
     bool FindRandomPointAroundCircle(const math::Vertex& centerPosition,
                                      float radius,
                                      math::Vertex& randomPoint) const;
 
+    // as above, for 'count' samples around the same center.  returns false if
+    // no point could be found
+    bool FindRandomPointsAroundCircle(
+        const math::Vertex& centerPosition, float radius, unsigned int count,
+        std::vector<math::Vertex>& randomPoints) const;
+
+    // the generator is seeded nondeterministically when the map is created.
+    // reseeding it makes all subsequent random point queries reproducible
+    void SeedRandom(std::uint64_t seed);
+
     bool FindPointInBetweenVectors(const math::Vertex& start,
                                    const math::Vertex& end,
                                    const float distance,
                                    math::Vertex& inBetweenPoint) const;
 
+    // moves from 'start' toward 'end' along the navmesh, as for a charge or a
+    // knockback, in one query.  'result' is the farthest point reached, with
+    // its height corrected against the collision geometry.  if a wall
+    // stopped the movement short of 'end', 'blocked' is set and 'hitNormal'
+    // is the normal of that wall, otherwise it is zero.  when 'slide' is set,
+    // the movement continues along the wall rather than stopping at it, and
+    // both describe the wall at which the slide ended, if any
+    bool MoveAlongSurface(const math::Vertex& start, const math::Vertex& end,
+                          math::Vertex& result, math::Vector3& hitNormal,
+                          bool& blocked, bool slide = false) const;
+
+    const QueryStatistics& GetStatistics() const { return m_statistics; }
+    void ResetStatistics() { m_statistics = {}; }
+
     const dtNavMesh& GetNavMesh() const { return m_navMesh; }
     const dtNavMeshQuery& GetNavMeshQuery() const { return m_navQuery; }
 };
@@ -1,9 +1,13 @@
 #pragma once
 
+#include "BVH.hpp"
 #include "utility/AABBTree.hpp"
 #include "utility/BoundingBox.hpp"
+#include "utility/MappedFile.hpp"
 #include "utility/Matrix.hpp"
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -27,20 +31,43 @@ struct DoodadInstance
     math::Matrix m_transformMatrix;
     math::Matrix m_inverseTransformMatrix;
     math::BoundingBox m_bounds;
-    std::string m_modelFilename;
+    ModelId m_modelId;
     std::vector<math::Vertex>
         m_translatedVertices; // wow coordinate space.  indices are obtained
                               // from model.
-    std::weak_ptr<DoodadModel> m_model;
+    // static instance models are loaded on first use
+    mutable std::weak_ptr<const DoodadModel> m_model;
+};
+
+// the doodads of one doodad set of a wmo model.  only loaded as needed, and
+// kept alive by the loaded instances which use the set
+struct DoodadSet
+{
+    std::vector<DoodadInstance> m_doodads;
+    // loaded doodads serve as reference counters for automatic unload
+    std::vector<std::shared_ptr<const DoodadModel>> m_models;
 };
 
 // only loaded as needed
 struct WmoModel : Model
 {
-    std::vector<std::vector<DoodadInstance>> m_doodadSets;
-    std::vector<std::vector<std::shared_ptr<DoodadModel>>> m_loadedDoodadSets;
+    // the offset in the .bvh file of the first doodad of each set, and the
+    // number of doodads in it, so that sets may be read when first needed
+    std::string m_bvhPath;
+    std::shared_ptr<const utility::MappedFile> m_file;
+    std::vector<std::pair<std::size_t, std::uint32_t>> m_doodadSetLocations;
     std::unordered_map<unsigned int, std::pair<unsigned int, unsigned int>>
         m_nameSetToAreaZone;
+
+    // the area and zone of the given name set, or zeroes if it is unknown.
+    // models are shared between threads, so this must not modify the map
+    std::pair<unsigned int, unsigned int> AreaAndZone(unsigned int nameSet) const
+    {
+        auto const i = m_nameSetToAreaZone.find(nameSet);
+        return i == m_nameSetToAreaZone.end()
+                   ? std::pair<unsigned int, unsigned int> {0, 0}
+                   : i->second;
+    }
 };
 
 // always loaded
@@ -51,7 +78,8 @@ struct WmoInstance
     math::Matrix m_transformMatrix;
     math::Matrix m_inverseTransformMatrix;
     math::BoundingBox m_bounds;
-    std::string m_modelFilename;
-    std::weak_ptr<WmoModel> m_model;
+    ModelId m_modelId;
+    // static instance models are loaded on first use
+    mutable std::weak_ptr<const WmoModel> m_model;
 };
 } // namespace pathfind
\ No newline at end of file
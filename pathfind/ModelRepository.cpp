@@ -0,0 +1,168 @@
+#include "ModelRepository.hpp"
+
+#include "Model.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace
+{
+std::size_t MemoryUsage(const pathfind::DoodadModel& model)
+{
+    return sizeof(model) + model.m_aabbTree.MemoryUsage();
+}
+
+std::size_t MemoryUsage(const pathfind::WmoModel& model)
+{
+    return sizeof(model) + model.m_aabbTree.MemoryUsage() +
+           model.m_doodadSetLocations.capacity() *
+               sizeof(model.m_doodadSetLocations[0]) +
+           model.m_nameSetToAreaZone.size() *
+               sizeof(decltype(model.m_nameSetToAreaZone)::value_type);
+}
+
+std::size_t MemoryUsage(const pathfind::DoodadSet& set)
+{
+    // the doodad models themselves are accounted for separately
+    return sizeof(set) +
+           set.m_doodads.capacity() *
+               (sizeof(pathfind::DoodadInstance) + 2 * 16 * sizeof(float)) +
+           set.m_models.capacity() * sizeof(set.m_models[0]);
+}
+} // namespace
+
+namespace pathfind
+{
+ModelRepository::ModelRepository()
+    : m_memoryUsage(std::make_shared<std::atomic<std::size_t>>(0)),
+      m_quantizeModels(false)
+{
+}
+
+template <typename T>
+template <typename LoadFunction, typename TrackFunction>
+typename ModelRepository::Cache<T>::Pointer
+ModelRepository::Cache<T>::Get(const std::string& key,
+                               const LoadFunction& load,
+                               const TrackFunction& track)
+{
+    std::promise<Pointer> promise;
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto const loaded = m_loaded.find(key);
+    if (loaded != m_loaded.end())
+        if (auto result = loaded->second.lock())
+            return result;
+
+    // another thread is already loading this model.  wait for it
+    auto const pending = m_pending.find(key);
+    if (pending != m_pending.end())
+    {
+        auto const future = pending->second;
+        lock.unlock();
+
+        return future.get();
+    }
+
+    m_pending[key] = promise.get_future().share();
+    lock.unlock();
+
+    Pointer result;
+
+    try
+    {
+        result = track(load());
+    }
+    catch (...)
+    {
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            m_pending.erase(key);
+        }
+
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+
+        m_loaded[key] = result;
+        m_pending.erase(key);
+
+        // drop the keys of models which have since been released, whenever
+        // the index has doubled in size
+        if (m_loaded.size() > 2 * m_prunedSize)
+        {
+            for (auto i = m_loaded.begin(); i != m_loaded.end();)
+            {
+                if (i->second.expired())
+                    i = m_loaded.erase(i);
+                else
+                    ++i;
+            }
+
+            m_prunedSize = m_loaded.size();
+        }
+    }
+
+    promise.set_value(result);
+
+    return result;
+}
+ModelRepository& ModelRepository::Instance()
+{
+    static ModelRepository instance;
+    return instance;
+}
+
+template <typename T>
+std::shared_ptr<const T>
+ModelRepository::Track(std::unique_ptr<T> model) const
+{
+    auto const size = ::MemoryUsage(*model);
+    auto const memoryUsage = m_memoryUsage;
+
+    *memoryUsage += size;
+
+    return std::shared_ptr<const T>(model.release(),
+                                    [memoryUsage, size](const T* p)
+                                    {
+                                        *memoryUsage -= size;
+                                        delete p;
+                                    });
+}
+
+std::shared_ptr<const DoodadModel> ModelRepository::GetDoodadModel(
+    const std::string& bvhPath,
+    const std::function<std::unique_ptr<DoodadModel>()>& load)
+{
+    return m_doodadModels.Get(
+        bvhPath, load, [this](std::unique_ptr<DoodadModel> model)
+        { return Track(std::move(model)); });
+}
+
+std::shared_ptr<const WmoModel> ModelRepository::GetWmoModel(
+    const std::string& bvhPath,
+    const std::function<std::unique_ptr<WmoModel>()>& load)
+{
+    return m_wmoModels.Get(bvhPath, load,
+                           [this](std::unique_ptr<WmoModel> model)
+                           { return Track(std::move(model)); });
+}
+
+std::shared_ptr<const DoodadSet> ModelRepository::GetDoodadSet(
+    const std::string& bvhPath, unsigned int set,
+    const std::function<std::unique_ptr<DoodadSet>()>& load)
+{
+    return m_doodadSets.Get(bvhPath + "#" + std::to_string(set), load,
+                            [this](std::unique_ptr<DoodadSet> doodadSet)
+                            { return Track(std::move(doodadSet)); });
+}
+} // namespace pathfind
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Model.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace pathfind
+{
+// a process wide store of immutable collision models, shared by every Map on
+// every thread.  models are keyed by the path of their .bvh file, and are
+// released once no Map holds them.  when several threads request the same
+// model at once, only one loads it while the others wait for the result.
+class ModelRepository
+{
+private:
+    template <typename T>
+    class Cache
+    {
+    private:
+        using Pointer = std::shared_ptr<const T>;
+
+        std::mutex m_mutex;
+        std::unordered_map<std::string, std::weak_ptr<const T>> m_loaded;
+        std::unordered_map<std::string, std::shared_future<Pointer>>
+            m_pending;
+
+        // size of m_loaded after expired entries were last removed
+        std::size_t m_prunedSize = 0;
+
+    public:
+        // 'track' wraps a newly loaded model in a shared pointer
+        template <typename LoadFunction, typename TrackFunction>
+        Pointer Get(const std::string& key, const LoadFunction& load,
+                    const TrackFunction& track);
+    };
+
+    Cache<DoodadModel> m_doodadModels;
+    Cache<WmoModel> m_wmoModels;
+    Cache<DoodadSet> m_doodadSets;
+
+    // shared with the deleter of every model, which may outlive this
+    std::shared_ptr<std::atomic<std::size_t>> m_memoryUsage;
+
+    std::atomic<bool> m_quantizeModels;
+
+    ModelRepository();
+
+    template <typename T>
+    std::shared_ptr<const T> Track(std::unique_ptr<T> model) const;
+
+public:
+    static ModelRepository& Instance();
+
+    ModelRepository(const ModelRepository&) = delete;
+
+    // return the model for the given key, calling 'load' to create it only if
+    // no Map in the process currently holds it
+    std::shared_ptr<const DoodadModel>
+    GetDoodadModel(const std::string& bvhPath,
+                   const std::function<std::unique_ptr<DoodadModel>()>& load);
+    std::shared_ptr<const WmoModel>
+    GetWmoModel(const std::string& bvhPath,
+                const std::function<std::unique_ptr<WmoModel>()>& load);
+    std::shared_ptr<const DoodadSet>
+    GetDoodadSet(const std::string& bvhPath, unsigned int set,
+                 const std::function<std::unique_ptr<DoodadSet>()>& load);
+
+    // approximate size, in bytes, of every model currently loaded
+    std::size_t MemoryUsage() const { return *m_memoryUsage; }
+
+    // when set, models loaded from then on have their trees quantized,
+    // trading a little traversal time for about half the memory
+    void SetQuantizeModels(bool quantize) { m_quantizeModels = quantize; }
+    bool QuantizeModels() const { return m_quantizeModels; }
+};
+
+} // namespace pathfind
@@ -0,0 +1,114 @@
+#include "PathCache.hpp"
+
+#include "Map.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace pathfind
+{
+PathCache::PathCache(const dtNavMesh& navMesh, std::size_t capacity)
+    : m_navMesh(navMesh), m_capacity(capacity)
+{
+}
+
+std::uint32_t PathCache::TileVersion(unsigned int tileIndex) const
+{
+    auto const i = m_tileVersions.find(tileIndex);
+    return i == m_tileVersions.end() ? 0 : i->second;
+}
+
+int PathCache::Get(dtPolyRef start, dtPolyRef end, dtPolyRef* corridor,
+                   int maxCorridor)
+{
+    auto const i = m_index.find({start, end});
+
+    if (i == m_index.end())
+        return 0;
+
+    auto const entry = i->second;
+
+    // entries are checked when they are used, so that changing a tile costs
+    // nothing more than bumping its version
+    for (auto const& tile : entry->tiles)
+    {
+        if (TileVersion(tile.first) != tile.second)
+        {
+            m_index.erase(i);
+            m_entries.erase(entry);
+            return 0;
+        }
+    }
+
+    auto const length = static_cast<int>(entry->corridor.size());
+
+    if (length > maxCorridor)
+        return 0;
+
+    std::copy(entry->corridor.begin(), entry->corridor.end(), corridor);
+
+    // move the entry to the front
+    m_entries.splice(m_entries.begin(), m_entries, entry);
+
+    return length;
+}
+
+void PathCache::Insert(const dtPolyRef* corridor, int length)
+{
+    if (!m_capacity || length <= 0)
+        return;
+
+    const Key key {corridor[0], corridor[length - 1]};
+
+    auto const existing = m_index.find(key);
+    if (existing != m_index.end())
+    {
+        m_entries.erase(existing->second);
+        m_index.erase(existing);
+    }
+    else if (m_entries.size() == m_capacity)
+    {
+        m_index.erase(m_entries.back().key);
+        m_entries.pop_back();
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.corridor.assign(corridor, corridor + length);
+
+    for (auto i = 0; i < length; ++i)
+    {
+        auto const tileIndex = m_navMesh.decodePolyIdTile(corridor[i]);
+
+        // corridors cross each tile in one contiguous run, almost always
+        if (entry.tiles.empty() || entry.tiles.back().first != tileIndex)
+            entry.tiles.emplace_back(tileIndex, TileVersion(tileIndex));
+    }
+
+    m_entries.push_front(std::move(entry));
+    m_index[key] = m_entries.begin();
+}
+
+void PathCache::Clear()
+{
+    m_entries.clear();
+    m_index.clear();
+}
+
+void Map::SetPathCacheCapacity(std::size_t capacity)
+{
+    if (!capacity)
+        m_pathCache.reset();
+    else if (!m_pathCache || m_pathCache->Capacity() != capacity)
+        m_pathCache = std::make_unique<PathCache>(m_navMesh, capacity);
+}
+
+void Map::ClearPathCache()
+{
+    if (m_pathCache)
+        m_pathCache->Clear();
+}
+} // namespace pathfind
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "recastnavigation/Detour/Include/DetourNavMesh.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace pathfind
+{
+// a bounded, least recently used cache of the corridors found by searches
+// between pairs of polys.  the straight path depends on the exact start and
+// end positions, so it is rebuilt from the cached corridor for each request.
+// every entry records the version of each tile it crosses, and is discarded
+// once any of them changes.
+class PathCache
+{
+private:
+    using Key = std::pair<dtPolyRef, dtPolyRef>;
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const
+        {
+            auto const hash = std::hash<dtPolyRef>();
+            return hash(key.first) ^ (hash(key.second) * 31);
+        }
+    };
+
+    struct Entry
+    {
+        Key key;
+        std::vector<dtPolyRef> corridor;
+        // (tile index, tile version) for every tile the corridor crosses
+        std::vector<std::pair<unsigned int, std::uint32_t>> tiles;
+    };
+
+    const dtNavMesh& m_navMesh;
+    const std::size_t m_capacity;
+
+    // most recently used first
+    std::list<Entry> m_entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_index;
+
+    std::unordered_map<unsigned int, std::uint32_t> m_tileVersions;
+
+    std::uint32_t TileVersion(unsigned int tileIndex) const;
+
+public:
+    PathCache(const dtNavMesh& navMesh, std::size_t capacity);
+
+    std::size_t Capacity() const { return m_capacity; }
+    std::size_t Size() const { return m_entries.size(); }
+
+    // writes the cached corridor from 'start' to 'end', returning its length.
+    // zero is returned if there is no entry, if one of the tiles it crosses
+    // has changed since it was stored, or if it does not fit in the buffer
+    int Get(dtPolyRef start, dtPolyRef end, dtPolyRef* corridor,
+            int maxCorridor);
+
+    // stores a complete corridor, evicting the least recently used entry if
+    // the cache is full
+    void Insert(const dtPolyRef* corridor, int length);
+
+    // invalidates every entry crossing the given tile
+    void OnTileChanged(unsigned int tileIndex) { ++m_tileVersions[tileIndex]; }
+
+    void Clear();
+};
+} // namespace pathfind
@@ -0,0 +1,374 @@
+#include "PathOracle.hpp"
+
+#include "Common.hpp"
+#include "Map.hpp"
+#include "recastnavigation/Detour/Include/DetourCommon.h"
+#include "recastnavigation/Detour/Include/DetourNavMesh.h"
+#include "utility/BinaryStream.hpp"
+#include "utility/Exception.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace
+{
+#pragma pack(push, 1)
+struct OracleFileHeader
+{
+    std::uint32_t sig;
+    std::uint32_t ver;
+    std::uint32_t kind;
+    std::uint32_t tileCount;
+    std::uint32_t polyCount;
+};
+#pragma pack(pop)
+
+void PolyCenter(const dtNavMesh& navMesh, dtPolyRef ref, float* result)
+{
+    const dtMeshTile* tile;
+    const dtPoly* poly;
+    navMesh.getTileAndPolyByRefUnsafe(ref, &tile, &poly);
+
+    dtVset(result, 0.f, 0.f, 0.f);
+
+    for (auto i = 0; i < poly->vertCount; ++i)
+        dtVadd(result, result, &tile->verts[poly->verts[i] * 3]);
+
+    dtVscale(result, result, 1.f / poly->vertCount);
+}
+
+// fnv-1a, over the parts of the tile data which are not rewritten when the
+// tile is added to a navmesh.  the links are, but the neighbours of each poly
+// edge from which they are built are not
+std::uint64_t HashTile(const dtMeshTile& tile)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+
+    auto const add = [&hash](const void* data, std::size_t size)
+    {
+        auto const bytes = static_cast<const std::uint8_t*>(data);
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    };
+
+    add(tile.verts, tile.header->vertCount * 3 * sizeof(float));
+
+    for (auto i = 0; i < tile.header->polyCount; ++i)
+    {
+        auto const& poly = tile.polys[i];
+
+        add(poly.verts, sizeof(poly.verts));
+        add(poly.neis, sizeof(poly.neis));
+        add(&poly.flags, sizeof(poly.flags));
+        add(&poly.vertCount, sizeof(poly.vertCount));
+        add(&poly.areaAndtype, sizeof(poly.areaAndtype));
+    }
+
+    return hash;
+}
+} // namespace
+
+namespace pathfind
+{
+bool PathOracle::BindToNavMesh(const dtNavMesh& navMesh)
+{
+    m_refs.clear();
+    m_ids.clear();
+
+    for (auto const& entry : m_tileEntries)
+    {
+        auto const tile = navMesh.getTileAt(entry.x, entry.y, 0);
+
+        if (!tile || !tile->header ||
+            tile->header->polyCount != static_cast<int>(entry.polyCount) ||
+            tile->header->vertCount != static_cast<int>(entry.vertCount) ||
+            HashTile(*tile) != entry.dataHash)
+            return false;
+
+        auto const base = navMesh.getPolyRefBase(tile);
+
+        for (auto i = 0u; i < entry.polyCount; ++i)
+        {
+            m_ids[base | i] = static_cast<std::uint16_t>(m_refs.size());
+            m_refs.push_back(base | i);
+        }
+    }
+
+    return true;
+}
+
+std::unique_ptr<PathOracle> PathOracle::Build(const PolyGraph& graph,
+                                              unsigned int maxPolys)
+{
+    auto const& navMesh = graph.NavMesh();
+
+    std::unique_ptr<PathOracle> result(new PathOracle());
+
+    std::size_t polyCount = 0;
+    for (auto i = 0; i < navMesh.getMaxTiles(); ++i)
+    {
+        auto const tile = navMesh.getTile(i);
+
+        if (!tile || !tile->header || !tile->dataSize)
+            continue;
+
+        result->m_tileEntries.push_back(
+            {tile->header->x, tile->header->y,
+             static_cast<std::uint32_t>(tile->header->polyCount),
+             static_cast<std::uint32_t>(tile->header->vertCount),
+             HashTile(*tile)});
+
+        polyCount += tile->header->polyCount;
+    }
+
+    // dense ids must fit in the 16 bit adjacency lists
+    if (!polyCount || polyCount > maxPolys ||
+        polyCount >= (std::numeric_limits<std::uint16_t>::max)())
+        return nullptr;
+
+    if (!result->BindToNavMesh(navMesh))
+        return nullptr;
+
+    auto const count = result->Count();
+
+    result->m_adjacencyStart.reserve(count + 1);
+
+    for (auto const ref : result->m_refs)
+    {
+        result->m_adjacencyStart.push_back(
+            static_cast<std::uint32_t>(result->m_adjacency.size()));
+
+        std::uint32_t neighbours = 0;
+        graph.ForEachNeighbour(ref,
+                               [&](dtPolyRef neighbour, const float*)
+                               {
+                                   // the table has no room for more than this
+                                   if (neighbours++ < NoHop)
+                                       result->m_adjacency.push_back(
+                                           result->m_ids[neighbour]);
+                               });
+    }
+
+    result->m_adjacencyStart.push_back(
+        static_cast<std::uint32_t>(result->m_adjacency.size()));
+
+    result->m_nextHop.assign(count * count, NoHop);
+
+    // one expansion per target.  the parent of each poly in the resulting
+    // tree is its next hop toward that target
+    PolyGraph::NodeMap nodes;
+    for (std::size_t to = 0; to < count; ++to)
+    {
+        float targetPos[3];
+        PolyCenter(navMesh, result->m_refs[to], targetPos);
+
+        nodes.clear();
+        graph.Expand(result->m_refs[to], targetPos,
+                     (std::numeric_limits<float>::max)(), nodes);
+
+        for (auto const& node : nodes)
+        {
+            if (!node.second.parent)
+                continue;
+
+            auto const from = result->m_ids[node.first];
+            auto const parent = result->m_ids[node.second.parent];
+
+            auto const begin =
+                result->m_adjacency.begin() + result->m_adjacencyStart[from];
+            auto const end = result->m_adjacency.begin() +
+                             result->m_adjacencyStart[from + 1];
+
+            auto const slot = std::find(begin, end, parent);
+
+            if (slot != end)
+                result->m_nextHop[from * count + to] =
+                    static_cast<std::uint8_t>(slot - begin);
+        }
+    }
+
+    return result;
+}
+
+std::unique_ptr<PathOracle> PathOracle::Load(utility::BinaryStream& in,
+                                             const dtNavMesh& navMesh)
+{
+    OracleFileHeader header;
+    in >> header;
+
+    if (header.sig != MeshSettings::FileSignature)
+        THROW(Result::INCORRECT_FILE_SIGNATURE);
+
+    if (header.ver != MeshSettings::FileVersion)
+        THROW(Result::INCORRECT_FILE_VERSION);
+
+    if (header.kind != MeshSettings::FileOracle)
+        THROW(Result::NOT_ORACLE_FILE);
+
+    // each section is sized from data already read, so check that the file
+    // really holds that much before allocating for it
+    auto const remaining = [&in](std::size_t size)
+    { return in.rpos() + size <= in.wpos(); };
+
+    if (!header.tileCount || !remaining(header.tileCount * sizeof(TileEntry)))
+        return nullptr;
+
+    std::unique_ptr<PathOracle> result(new PathOracle());
+
+    result->m_tileEntries.resize(header.tileCount);
+    in.ReadBytes(&result->m_tileEntries[0],
+                 header.tileCount * sizeof(TileEntry));
+
+    // the navmesh has been rebuilt since the oracle was.  rather than fail,
+    // continue without it
+    if (!result->BindToNavMesh(navMesh) || result->Count() != header.polyCount)
+        return nullptr;
+
+    auto const count = result->Count();
+
+    if (!remaining((count + 1) * sizeof(std::uint32_t)))
+        return nullptr;
+
+    result->m_adjacencyStart.resize(count + 1);
+    in.ReadBytes(&result->m_adjacencyStart[0],
+                 result->m_adjacencyStart.size() * sizeof(std::uint32_t));
+
+    auto const& start = result->m_adjacencyStart;
+
+    // the lists must follow one another, and no poly may have more
+    // neighbours than the table can index
+    if (start.front() != 0)
+        return nullptr;
+
+    for (std::size_t i = 1; i < start.size(); ++i)
+        if (start[i] < start[i - 1] || start[i] - start[i - 1] > NoHop)
+            return nullptr;
+
+    if (!remaining(start.back() * sizeof(std::uint16_t) + count * count))
+        return nullptr;
+
+    result->m_adjacency.resize(start.back());
+    if (!result->m_adjacency.empty())
+        in.ReadBytes(&result->m_adjacency[0],
+                     result->m_adjacency.size() * sizeof(std::uint16_t));
+
+    for (auto const neighbour : result->m_adjacency)
+        if (neighbour >= count)
+            return nullptr;
+
+    result->m_nextHop.resize(count * count);
+    in.ReadBytes(&result->m_nextHop[0], result->m_nextHop.size());
+
+    // every hop must index the neighbour list of the poly it leaves
+    for (std::size_t from = 0; from < count; ++from)
+    {
+        auto const degree = start[from + 1] - start[from];
+
+        for (std::size_t to = 0; to < count; ++to)
+        {
+            auto const slot = result->m_nextHop[from * count + to];
+
+            if (slot != NoHop && slot >= degree)
+                return nullptr;
+        }
+    }
+
+    return result;
+}
+
+void PathOracle::Serialize(const std::filesystem::path& path) const
+{
+    auto const count = Count();
+
+    utility::BinaryStream out(
+        sizeof(OracleFileHeader) + m_tileEntries.size() * sizeof(TileEntry) +
+        m_adjacencyStart.size() * sizeof(std::uint32_t) +
+        m_adjacency.size() * sizeof(std::uint16_t) + m_nextHop.size());
+
+    OracleFileHeader header;
+    header.sig = MeshSettings::FileSignature;
+    header.ver = MeshSettings::FileVersion;
+    header.kind = MeshSettings::FileOracle;
+    header.tileCount = static_cast<std::uint32_t>(m_tileEntries.size());
+    header.polyCount = static_cast<std::uint32_t>(count);
+
+    out << header;
+    out.Write(&m_tileEntries[0], m_tileEntries.size() * sizeof(TileEntry));
+    out.Write(&m_adjacencyStart[0],
+              m_adjacencyStart.size() * sizeof(std::uint32_t));
+    if (!m_adjacency.empty())
+        out.Write(&m_adjacency[0], m_adjacency.size() * sizeof(std::uint16_t));
+    out.Write(&m_nextHop[0], m_nextHop.size());
+
+    // the table is mostly runs of identical hops, and compresses well
+    out.Compress();
+
+    std::ofstream o(path, std::ofstream::binary | std::ofstream::trunc);
+
+    if (o.fail())
+        THROW(Result::PATH_ORACLE_SERIALIZATION_FAILED_TO_OPEN_OUTPUT_FILE);
+
+    o << out;
+}
+
+int PathOracle::GetCorridor(dtPolyRef start, dtPolyRef end,
+                            dtPolyRef* corridor, int maxCorridor) const
+{
+    auto const startId = m_ids.find(start);
+    auto const endId = m_ids.find(end);
+
+    if (startId == m_ids.end() || endId == m_ids.end() || maxCorridor <= 0)
+        return 0;
+
+    auto const count = Count();
+    auto const to = endId->second;
+
+    int length = 0;
+    corridor[length++] = start;
+
+    for (std::size_t from = startId->second; from != to;)
+    {
+        auto const slot = m_nextHop[from * count + to];
+
+        if (slot == NoHop || length == maxCorridor)
+            return 0;
+
+        from = m_adjacency[m_adjacencyStart[from] + slot];
+        corridor[length++] = m_refs[from];
+    }
+
+    return length;
+}
+
+bool Map::BuildPathOracle(unsigned int maxPolys)
+{
+    // maps with adts load and unload tiles at will, so dense ids assigned to
+    // their polys would not remain valid
+    if (m_hasADTs)
+        return false;
+
+    const PolyGraph graph(m_navMesh, m_queryFilter);
+    auto oracle = PathOracle::Build(graph, maxPolys);
+
+    if (!oracle)
+        return false;
+
+    oracle->Serialize(m_dataPath / "Nav" / m_mapName / "Map.oracle");
+    m_pathOracle = std::move(oracle);
+
+    return true;
+}
+
+bool Map::HasPathOracle() const
+{
+    return !!m_pathOracle;
+}
+} // namespace pathfind
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "PolyGraph.hpp"
+#include "recastnavigation/Detour/Include/DetourNavMesh.h"
+#include "utility/BinaryStream.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace pathfind
+{
+// a precomputed next hop table between every pair of polys on a small map.
+// polys are assigned dense ids in the order their tiles appear in the navmesh,
+// and for each pair of ids the table stores which neighbour of the first poly
+// lies on the shortest path toward the second.  the corridor between any two
+// polys is then read in O(path length) with no search.
+class PathOracle
+{
+public:
+    // beyond this, the n^2 table becomes too large to be worthwhile
+    static constexpr unsigned int DefaultMaxPolys = 4096;
+
+private:
+    static constexpr std::uint8_t NoHop = 0xFF;
+
+    struct TileEntry
+    {
+        std::int32_t x;
+        std::int32_t y;
+        std::uint32_t polyCount;
+        std::uint32_t vertCount;
+        // of the tile's vertices and polys, including their neighbours
+        std::uint64_t dataHash;
+    };
+
+    std::vector<TileEntry> m_tileEntries;
+
+    // neighbours of each poly, by dense id, as they were when the table was
+    // built.  the table stores indices into these lists
+    std::vector<std::uint32_t> m_adjacencyStart;
+    std::vector<std::uint16_t> m_adjacency;
+
+    // m_nextHop[from * count + to]
+    std::vector<std::uint8_t> m_nextHop;
+
+    // runtime mapping between dense ids and the current navmesh poly refs
+    std::vector<dtPolyRef> m_refs;
+    std::unordered_map<dtPolyRef, std::uint16_t> m_ids;
+
+    std::size_t Count() const { return m_refs.size(); }
+
+    // assign dense ids to the polys of the given navmesh.  returns false if
+    // the navmesh does not match the recorded tile entries
+    bool BindToNavMesh(const dtNavMesh& navMesh);
+
+public:
+    // returns nullptr if the navmesh has more than 'maxPolys' polys
+    static std::unique_ptr<PathOracle> Build(const PolyGraph& graph,
+                                             unsigned int maxPolys);
+
+    // returns nullptr if the data was built for a different navmesh, or if
+    // it is truncated or inconsistent
+    static std::unique_ptr<PathOracle> Load(utility::BinaryStream& in,
+                                            const dtNavMesh& navMesh);
+
+    void Serialize(const std::filesystem::path& path) const;
+
+    // writes the corridor from 'start' to 'end', returning its length.  zero
+    // is returned if either poly is unknown to the oracle, if 'end' is not
+    // reachable from 'start', or if the corridor does not fit in the buffer
+    int GetCorridor(dtPolyRef start, dtPolyRef end, dtPolyRef* corridor,
+                    int maxCorridor) const;
+};
+} // namespace pathfind
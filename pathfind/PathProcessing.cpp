@@ -0,0 +1,329 @@
+#include "Map.hpp"
+
+#include "Common.hpp"
+#include "Tile.hpp"
+#include "recastnavigation/Detour/Include/DetourCommon.h"
+#include "recastnavigation/Detour/Include/DetourNavMesh.h"
+#include "recastnavigation/Detour/Include/DetourNavMeshQuery.h"
+#include "utility/MathHelper.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace pathfind
+{
+bool Map::SnapHeight(const dtPolyRef* corridor, int corridorSize,
+                     int& current, float* position) const
+{
+    // samples are taken in order along the corridor, so the search for the
+    // containing poly resumes from where the previous one was found
+    for (auto i = current; i < corridorSize; ++i)
+    {
+        float height;
+        if (!!(m_navQuery.getPolyHeight(corridor[i], position, &height) &
+               DT_SUCCESS))
+        {
+            current = i;
+            position[1] = height;
+            return true;
+        }
+    }
+
+    // the point has strayed from the corridor, perhaps because the ray
+    // grazed a wall.  fall back to a search around it
+    constexpr float extents[] = {5.f, 5.f, 5.f};
+
+    dtPolyRef polyRef;
+    float nearest[3];
+    if (!(m_navQuery.findNearestPoly(position, extents, &m_queryFilter,
+                                     &polyRef, nearest) &
+          DT_SUCCESS) ||
+        !polyRef)
+        return false;
+
+    position[1] = nearest[1];
+    return true;
+}
+
+bool Map::FindPathWithPreciseHeights(const math::Vertex& start,
+                                     const math::Vertex& end,
+                                     std::vector<math::Vertex>& output,
+                                     bool allowPartial) const
+{
+    std::vector<dtPolyRef> polyRefs;
+
+    if (!FindStraightPath(start, end, output, allowPartial, &polyRefs))
+        return false;
+
+    // straight path corners take the height of the poly vertices.  the poly
+    // of each is already known, so the detail mesh height is a cheap and
+    // better starting point for the search
+    for (auto i = 0u; i < output.size(); ++i)
+    {
+        float recastPoint[3];
+        math::Convert::VertexToRecast(output[i], recastPoint);
+
+        float height;
+        if (!!polyRefs[i] &&
+            !!(m_navQuery.getPolyHeight(polyRefs[i], recastPoint, &height) &
+               DT_SUCCESS))
+            output[i].Z = height;
+    }
+
+    CorrectHeights(output.data(), output.size());
+
+    return true;
+}
+
+void Map::CorrectHeights(math::Vertex* points, std::size_t count) const
+{
+    struct Entry
+    {
+        const Tile* tile;
+        std::size_t index;
+    };
+
+    std::vector<Entry> entries;
+    entries.reserve(count);
+
+    for (auto i = 0u; i < count; ++i)
+        if (auto const tile = GetTile(points[i].X, points[i].Y))
+            entries.push_back({tile, i});
+
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.tile < b.tile; });
+
+    std::vector<math::Ray> rays;
+    std::unique_ptr<bool[]> hits(new bool[entries.size()]);
+
+    for (auto begin = 0u; begin < entries.size();)
+    {
+        auto const tile = entries[begin].tile;
+
+        auto end = begin;
+        rays.clear();
+
+        for (; end < entries.size() && entries[end].tile == tile; ++end)
+        {
+            auto const& point = points[entries[end].index];
+            rays.push_back(
+                {point, {point.X, point.Y, tile->m_bounds.getMinimum().Z}});
+        }
+
+        RayCast(tile, rays.data(), rays.size(), &hits[begin]);
+
+        for (auto i = begin; i < end; ++i)
+        {
+            auto& point = points[entries[i].index];
+
+            float z;
+            if (ResolveNextZ(tile, point.X, point.Y, point.Z, hits[i],
+                             rays[i - begin].GetHitPoint().Z, true, z))
+                point.Z = z;
+        }
+
+        begin = end;
+    }
+}
+
+bool Map::ResamplePath(const std::vector<math::Vertex>& path, float step,
+                       std::vector<math::Vertex>& output, bool precise) const
+{
+    if (path.size() < 2 || step <= 0.f)
+        return false;
+
+    constexpr float extents[] = {5.f, 5.f, 5.f};
+
+    // reserve once for the whole path, so that no sample allocates
+    float totalLength = 0.f;
+    for (auto i = 1u; i < path.size(); ++i)
+        totalLength += path[i - 1].GetDistance(path[i]);
+
+    output.reserve(output.size() + static_cast<size_t>(totalLength / step) +
+                   2);
+
+    float recastStart[3];
+    math::Convert::VertexToRecast(path[0], recastStart);
+
+    dtPolyRef polyRef;
+    if (!(m_navQuery.findNearestPoly(recastStart, extents, &m_queryFilter,
+                                     &polyRef, nullptr) &
+          DT_SUCCESS) ||
+        !polyRef)
+        return false;
+
+    auto const firstPoint = output.size();
+
+    auto const emit = [&output](const float* position)
+    {
+        output.emplace_back();
+        math::Convert::VertexToWow(position, output.back());
+    };
+
+    dtPolyRef corridor[MaxStackedPolys];
+    int corridorSize = 0;
+    int current = 0;
+
+    // distance along the current segment of the next sample
+    float offset = 0.f;
+
+    for (auto i = 1u; i < path.size(); ++i)
+    {
+        float a[3], b[3];
+        math::Convert::VertexToRecast(path[i - 1], a);
+        math::Convert::VertexToRecast(path[i], b);
+
+        // one ray along the navmesh yields every poly this segment crosses
+        dtRaycastHit hit;
+        hit.path = corridor;
+        hit.maxPath = MaxStackedPolys;
+        hit.pathCount = 0;
+
+        current = 0;
+
+        auto const reachedEnd =
+            !!polyRef &&
+            !!(m_navQuery.raycast(polyRef, a, b, &m_queryFilter, 0, &hit) &
+               DT_SUCCESS) &&
+            hit.t == FLT_MAX;
+
+        corridorSize = hit.pathCount;
+
+        auto const length = dtVdist(a, b);
+
+        for (; offset < length; offset += step)
+        {
+            float sample[3];
+            dtVlerp(sample, a, b, offset / length);
+
+            if (SnapHeight(corridor, corridorSize, current, sample))
+                emit(sample);
+        }
+
+        offset -= length;
+
+        // the next segment begins where this one ended
+        if (reachedEnd && corridorSize > 0)
+            polyRef = corridor[corridorSize - 1];
+        else if (!(m_navQuery.findNearestPoly(b, extents, &m_queryFilter,
+                                              &polyRef, nullptr) &
+                   DT_SUCCESS))
+            polyRef = 0;
+    }
+
+    float end[3];
+    math::Convert::VertexToRecast(path.back(), end);
+
+    current = 0;
+    if (SnapHeight(corridor, corridorSize, current, end))
+        emit(end);
+
+    // take the imprecise z values from the mesh, and refine them
+    if (precise)
+        CorrectHeights(output.data() + firstPoint, output.size() - firstPoint);
+
+    return true;
+}
+
+bool Map::SimplifyPath(std::vector<math::Vertex>& path,
+                       float heightTolerance) const
+{
+    if (path.size() < 3)
+        return true;
+
+    constexpr float extents[] = {5.f, 5.f, 5.f};
+
+    std::vector<float> recastPath(path.size() * 3);
+    std::vector<dtPolyRef> polyRefs(path.size());
+
+    for (auto i = 0u; i < path.size(); ++i)
+    {
+        math::Convert::VertexToRecast(path[i], &recastPath[i * 3]);
+
+        if (!(m_navQuery.findNearestPoly(&recastPath[i * 3], extents,
+                                         &m_queryFilter, &polyRefs[i],
+                                         nullptr) &
+              DT_SUCCESS))
+            polyRefs[i] = 0;
+    }
+
+    // true if every point strictly between 'from' and 'to' may be dropped
+    auto const canSkip = [&](size_t from, size_t to)
+    {
+        if (!polyRefs[from] || !polyRefs[to])
+            return false;
+
+        auto const& a = path[from];
+        auto const& b = path[to];
+
+        auto const dx = b.X - a.X;
+        auto const dy = b.Y - a.Y;
+        auto const lengthSquared = dx * dx + dy * dy;
+
+        // the points being dropped must lie close to the height of the line
+        // which replaces them, or the path would cut through slopes
+        for (auto i = from + 1; i < to; ++i)
+        {
+            auto t = lengthSquared > 0.f
+                         ? ((path[i].X - a.X) * dx + (path[i].Y - a.Y) * dy) /
+                               lengthSquared
+                         : 0.f;
+            t = (std::max)(0.f, (std::min)(1.f, t));
+
+            if (fabs(path[i].Z - (a.Z + t * (b.Z - a.Z))) > heightTolerance)
+                return false;
+        }
+
+        dtPolyRef hitPath[MaxStackedPolys];
+
+        dtRaycastHit hit;
+        hit.path = hitPath;
+        hit.maxPath = MaxStackedPolys;
+        hit.pathCount = 0;
+
+        if (!(m_navQuery.raycast(polyRefs[from], &recastPath[from * 3],
+                                 &recastPath[to * 3], &m_queryFilter, 0, &hit) &
+              DT_SUCCESS) ||
+            hit.t != FLT_MAX || !hit.pathCount)
+            return false;
+
+        auto const last = hit.path[hit.pathCount - 1];
+
+        if (last == polyRefs[to])
+            return true;
+
+        // corners of a straight path lie on vertices and edges shared by
+        // several polys, so the nearest poly found for 'to' may be any of
+        // them.  the ray reached 'to' within its last poly, and it is the
+        // same point so long as that poly is at the same height there, and
+        // not on a floor above or below
+        float height;
+        return !!(m_navQuery.getPolyHeight(last, &recastPath[to * 3],
+                                           &height) &
+                  DT_SUCCESS) &&
+               fabs(height - recastPath[to * 3 + 1]) <=
+                   (std::max)(heightTolerance, MeshSettings::WalkableClimb);
+    };
+
+    // greedily extend each kept point as far along the path as possible
+    size_t kept = 0;
+    size_t anchor = 0;
+
+    for (auto i = 2u; i < path.size(); ++i)
+    {
+        if (canSkip(anchor, i))
+            continue;
+
+        anchor = i - 1;
+        path[++kept] = path[anchor];
+    }
+
+    path[++kept] = path.back();
+    path.resize(kept + 1);
+
+    return true;
+}
+} // namespace pathfind
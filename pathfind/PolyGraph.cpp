@@ -0,0 +1,174 @@
+#include "PolyGraph.hpp"
+
+#include "recastnavigation/Detour/Include/DetourCommon.h"
+#include "recastnavigation/Detour/Include/DetourNavMesh.h"
+
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace pathfind
+{
+void PolyGraph::PortalMidpoint(const dtMeshTile* tile, const dtPoly* poly,
+                               const dtLink& link, float* result)
+{
+    auto const left = &tile->verts[poly->verts[link.edge] * 3];
+    auto const right =
+        &tile->verts[poly->verts[(link.edge + 1) % poly->vertCount] * 3];
+
+    // links between tiles may only cover part of the edge.  this mirrors
+    // dtNavMeshQuery::getPortalPoints()
+    if (link.side != 0xff && (link.bmin != 0 || link.bmax != 255))
+    {
+        constexpr float s = 1.f / 255.f;
+
+        float a[3], b[3];
+        dtVlerp(a, left, right, link.bmin * s);
+        dtVlerp(b, left, right, link.bmax * s);
+        dtVlerp(result, a, b, 0.5f);
+        return;
+    }
+
+    dtVlerp(result, left, right, 0.5f);
+}
+
+float PolyGraph::Cost(const float* a, const float* b, dtPolyRef ref) const
+{
+    const dtMeshTile* tile;
+    const dtPoly* poly;
+    m_navMesh.getTileAndPolyByRefUnsafe(ref, &tile, &poly);
+
+    return m_filter.getCost(a, b, 0, nullptr, nullptr, ref, tile, poly, 0,
+                            nullptr, nullptr);
+}
+
+void PolyGraph::Expand(dtPolyRef startRef, const float* startPos,
+                       float maxCost, NodeMap& nodes) const
+{
+    using Entry = std::pair<float, dtPolyRef>;
+
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+
+    auto& start = nodes[startRef];
+    start.parent = 0;
+    start.cost = 0.f;
+    dtVcopy(start.pos, startPos);
+
+    open.push({0.f, startRef});
+
+    while (!open.empty())
+    {
+        auto const current = open.top();
+        open.pop();
+
+        auto const& node = nodes[current.second];
+
+        // stale entry, this poly has since been reached more cheaply
+        if (current.first > node.cost)
+            continue;
+
+        // copied because inserting neighbours may invalidate 'node'
+        auto const cost = node.cost;
+        float pos[3];
+        dtVcopy(pos, node.pos);
+
+        ForEachNeighbour(current.second,
+                         [&](dtPolyRef neighbour, const float* portal)
+                         {
+                             auto const total =
+                                 cost + Cost(pos, portal, current.second);
+
+                             if (total > maxCost)
+                                 return;
+
+                             auto const existing = nodes.find(neighbour);
+
+                             if (existing != nodes.end() &&
+                                 existing->second.cost <= total)
+                                 return;
+
+                             auto& next = nodes[neighbour];
+                             next.parent = current.second;
+                             next.cost = total;
+                             dtVcopy(next.pos, portal);
+
+                             open.push({total, neighbour});
+                         });
+    }
+}
+
+bool PolyGraph::Search(dtPolyRef startRef, const float* startPos,
+                       dtPolyRef endRef, const float* endPos, float maxCost,
+                       NodeMap& nodes, float& cost) const
+{
+    using Entry = std::pair<float, dtPolyRef>;
+
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+
+    nodes.clear();
+
+    auto& start = nodes[startRef];
+    start.parent = 0;
+    start.cost = 0.f;
+    dtVcopy(start.pos, startPos);
+
+    // the straight line distance is never more than the cost to the end, so
+    // long as no area costs less than one per unit distance
+    open.push({dtVdist(startPos, endPos), startRef});
+
+    while (!open.empty())
+    {
+        auto const current = open.top();
+        open.pop();
+
+        // every remaining candidate is at least this expensive
+        if (current.first > maxCost)
+            return false;
+
+        auto const& node = nodes[current.second];
+
+        // stale entry, this poly has since been reached more cheaply
+        if (current.first > node.cost + dtVdist(node.pos, endPos))
+            continue;
+
+        if (current.second == endRef)
+        {
+            cost = node.cost + Cost(node.pos, endPos, endRef);
+            return cost <= maxCost;
+        }
+
+        // copied because inserting neighbours may invalidate 'node'
+        auto const nodeCost = node.cost;
+        float pos[3];
+        dtVcopy(pos, node.pos);
+
+        ForEachNeighbour(current.second,
+                         [&](dtPolyRef neighbour, const float* portal)
+                         {
+                             auto const total =
+                                 nodeCost + Cost(pos, portal, current.second);
+                             auto const estimate =
+                                 total + dtVdist(portal, endPos);
+
+                             if (estimate > maxCost)
+                                 return;
+
+                             auto const existing = nodes.find(neighbour);
+
+                             if (existing != nodes.end() &&
+                                 existing->second.cost <= total)
+                                 return;
+
+                             auto& next = nodes[neighbour];
+                             next.parent = current.second;
+                             next.cost = total;
+                             dtVcopy(next.pos, portal);
+
+                             open.push({estimate, neighbour});
+                         });
+    }
+
+    return false;
+}
+} // namespace pathfind
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "recastnavigation/Detour/Include/DetourNavMesh.h"
+#include "recastnavigation/Detour/Include/DetourNavMeshQuery.h"
+
+#include <unordered_map>
+
+namespace pathfind
+{
+// a view of the navmesh polygons as a graph, for searches which detour does
+// not offer through dtNavMeshQuery.  positions are in recast coordinates.
+class PolyGraph
+{
+public:
+    struct Node
+    {
+        // the poly from which this poly was reached
+        dtPolyRef parent;
+        // accumulated cost from the search origin to 'pos'
+        float cost;
+        // point at which the search entered this poly
+        float pos[3];
+    };
+
+    using NodeMap = std::unordered_map<dtPolyRef, Node>;
+
+private:
+    const dtNavMesh& m_navMesh;
+    const dtQueryFilter& m_filter;
+
+    static void PortalMidpoint(const dtMeshTile* tile, const dtPoly* poly,
+                               const dtLink& link, float* result);
+
+public:
+    PolyGraph(const dtNavMesh& navMesh, const dtQueryFilter& filter)
+        : m_navMesh(navMesh), m_filter(filter)
+    {
+    }
+
+    const dtNavMesh& NavMesh() const { return m_navMesh; }
+
+    // index of the tile containing the given poly.  this is not stable
+    // across tile unload and reload
+    unsigned int TileIndex(dtPolyRef ref) const
+    {
+        return m_navMesh.decodePolyIdTile(ref);
+    }
+
+    // cost of moving from 'a' to 'b' within the given poly
+    float Cost(const float* a, const float* b, dtPolyRef ref) const;
+
+    // calls f(neighbourRef, portalMidpoint) for every poly adjacent to the
+    // given poly which passes the filter
+    template <typename F>
+    void ForEachNeighbour(dtPolyRef ref, F&& f) const
+    {
+        const dtMeshTile* tile;
+        const dtPoly* poly;
+        m_navMesh.getTileAndPolyByRefUnsafe(ref, &tile, &poly);
+
+        for (auto i = poly->firstLink; i != DT_NULL_LINK;
+             i = tile->links[i].next)
+        {
+            auto const& link = tile->links[i];
+
+            if (!link.ref)
+                continue;
+
+            const dtMeshTile* neighbourTile;
+            const dtPoly* neighbourPoly;
+            m_navMesh.getTileAndPolyByRefUnsafe(link.ref, &neighbourTile,
+                                                &neighbourPoly);
+
+            if (!m_filter.passFilter(link.ref, neighbourTile, neighbourPoly))
+                continue;
+
+            float portal[3];
+            PortalMidpoint(tile, poly, link, portal);
+
+            f(link.ref, static_cast<const float*>(portal));
+        }
+    }
+
+    // dijkstra expansion outward from the given poly.  every poly reachable
+    // for no more than 'maxCost' is recorded in 'nodes', along with its parent
+    // in the resulting shortest path tree
+    void Expand(dtPolyRef startRef, const float* startPos, float maxCost,
+                NodeMap& nodes) const;
+
+    // a* search from the start poly to the end poly, which gives up once no
+    // remaining candidate could arrive for 'maxCost' or less.  'nodes' is
+    // used as scratch space
+    bool Search(dtPolyRef startRef, const float* startPos, dtPolyRef endRef,
+                const float* endPos, float maxCost, NodeMap& nodes,
+                float& cost) const;
+};
+} // namespace pathfind
@@ -9,9 +9,14 @@
 #include "utility/Vector.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
+#include <exception>
+#include <future>
 #include <iomanip>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <thread>
 
@@ -231,15 +236,17 @@ void Map::AddGameObject(std::uint64_t guid, unsigned int displayId,
                         const math::Vector3& position,
                         const math::Matrix& rotation, int /*doodadSet*/)
 {
-    if (m_temporaryDoodads.find(guid) != m_temporaryDoodads.end() ||
+    // the guid of an obstacle whose tiles have all been unloaded is free
+    auto const existing = m_temporaryDoodads.find(guid);
+    if ((existing != m_temporaryDoodads.end() && !existing->second.expired()) ||
         m_temporaryWmos.find(guid) != m_temporaryWmos.end())
         THROW(Result::GAMEOBJECT_WITH_SPECIFIED_GUID_ALREADY_EXISTS);
 
     auto const matrix =
         math::Matrix::CreateTranslationMatrix(position) * rotation;
 
-    auto const bvh_path = m_bvhLoader.GetBVHPath(displayId);
-    // TODO: Add logic based on bvh_path
+    auto const modelId = m_bvhLoader.GetModelId(displayId);
+    // TODO: Add logic based on the bvh path
     auto const doodad = true;
     // auto const doodad = m_temporaryObstaclePaths[displayId][0] == 'd' ||
     // m_temporaryObstaclePaths[displayId][0] == 'D';
@@ -250,16 +257,17 @@ void Map::AddGameObject(std::uint64_t guid, unsigned int displayId,
 
         instance->m_transformMatrix = matrix;
         instance->m_inverseTransformMatrix = matrix.ComputeInverse();
-        instance->m_modelFilename = bvh_path;
-        auto model = EnsureDoodadModelLoaded(bvh_path);
+        instance->m_modelId = modelId;
+        auto model = EnsureDoodadModelLoaded(modelId);
         instance->m_model = model;
 
-        instance->m_translatedVertices.reserve(
-            model->m_aabbTree.Vertices().size());
+        auto const& tree = model->m_aabbTree;
 
-        for (auto const& v : model->m_aabbTree.Vertices())
+        instance->m_translatedVertices.reserve(tree.VertexCount());
+
+        for (auto i = 0u; i < tree.VertexCount(); ++i)
             instance->m_translatedVertices.emplace_back(
-                math::Vector3::Transform(v, matrix));
+                math::Vector3::Transform(tree.Vertices()[i], matrix));
 
         // models are guarunteed to have more than zero vertices
         math::BoundingBox bounds {instance->m_translatedVertices[0],
@@ -269,15 +277,55 @@ void Map::AddGameObject(std::uint64_t guid, unsigned int displayId,
             bounds.update(instance->m_translatedVertices[i]);
 
         instance->m_bounds = bounds;
+
+        // the tiles overlapped are found through the tile grid, rather than
+        // by testing every loaded tile
+        int minX, minY, maxX, maxY;
+        GetTileRange(bounds, minX, minY, maxX, maxY);
+
+        auto held = false;
+
+        for (auto y = minY; y <= maxY; ++y)
+            for (auto x = minX; x <= maxX; ++x)
+            {
+                auto const tile = m_tiles.find({x, y});
+
+                if (tile == m_tiles.end() ||
+                    !tile->second->m_bounds.intersect2d(bounds))
+                    continue;
+
+                held = true;
+
+                if (m_backgroundRebuilds)
+                {
+                    // queries see the obstacle at once, and the navmesh
+                    // catches up once the tile has been rebuilt
+                    tile->second->m_temporaryDoodads[guid] = instance;
+                    QueueTileRebuild({x, y}, *tile->second, instance);
+                }
+                else if (m_gameObjectBatch)
+                {
+                    tile->second->RasterizeTemporaryDoodad(guid, instance);
+                    m_dirtyTiles.insert({x, y});
+                }
+                else
+                    tile->second->AddTemporaryDoodad(guid, instance);
+            }
+
+        // nothing holds an obstacle which overlaps no loaded tile
+        if (!held)
+            return;
+
         m_temporaryDoodads[guid] = instance;
 
-        for (auto const& tile : m_tiles)
-        {
-            if (!tile.second->m_bounds.intersect2d(instance->m_bounds))
-                continue;
+        // tiles in range which are not yet loaded receive the obstacle when
+        // they are, should it still be held by then
+        for (auto y = minY; y <= maxY; ++y)
+            for (auto x = minX; x <= maxX; ++x)
+                m_temporaryObstacleTiles[{x, y}].push_back(guid);
 
-            tile.second->AddTemporaryDoodad(guid, instance);
-        }
+        if (m_lineOfSightCache)
+            m_lineOfSightCache->Invalidate(bounds);
     }
     else
     {
@@ -298,33 +346,356 @@ void Map::AddGameObject(std::uint64_t guid, unsigned int displayId,
     }
 }
 
+void Map::BeginGameObjectBatch()
+{
+    m_gameObjectBatch = true;
+}
+
+void Map::CommitGameObjectBatch()
+{
+    m_gameObjectBatch = false;
+
+    std::vector<Tile*> tiles;
+    tiles.reserve(m_dirtyTiles.size());
+
+    // a tile may have been unloaded since an obstacle was added to it
+    for (auto const& coords : m_dirtyTiles)
+    {
+        auto const tile = m_tiles.find(coords);
+
+        if (tile != m_tiles.end())
+            tiles.push_back(tile->second.get());
+    }
+
+    m_dirtyTiles.clear();
+
+    RebuildTiles(tiles);
+}
+
+void Map::SetBackgroundTileRebuilds(bool enable)
+{
+    if (!enable)
+        WaitForTileRebuilds();
+    else if (!m_rebuildPool)
+        m_rebuildPool = std::make_unique<utility::WorkerPool>(
+            (std::max)(1u, std::thread::hardware_concurrency()));
+
+    m_backgroundRebuilds = enable;
+}
+
+void Map::SetTileRebuiltCallback(std::function<void(int, int)> callback)
+{
+    m_tileRebuiltCallback = std::move(callback);
+}
+
+void Map::QueueTileRebuild(const std::pair<int, int>& coords, Tile& tile,
+                           std::shared_ptr<const DoodadInstance> obstacle)
+{
+    auto& rebuild = m_tileRebuilds[coords];
+
+    std::lock_guard<std::mutex> guard(m_tileRebuildMutex);
+
+    rebuild.tile = &tile;
+    rebuild.pending.push_back(std::move(obstacle));
+
+    if (rebuild.building)
+        return;
+
+    rebuild.building = true;
+
+    // entries are never moved by the map, so the reference remains valid
+    // for as long as the build, which the entry outlives
+    m_rebuildPool->Submit([this, &rebuild]() { BuildTile(rebuild); });
+}
+
+void Map::BuildTile(TileRebuild& rebuild)
+{
+    std::unique_lock<std::mutex> lock(m_tileRebuildMutex);
+
+    // the height field belongs to this build until it finds nothing pending,
+    // so obstacles added while it runs are built by its next pass
+    while (!rebuild.pending.empty())
+    {
+        auto const obstacles = std::move(rebuild.pending);
+        rebuild.pending.clear();
+
+        lock.unlock();
+
+        std::vector<std::uint8_t> mesh;
+        std::exception_ptr error;
+
+        try
+        {
+            for (auto const& obstacle : obstacles)
+                rebuild.tile->RasterizeDoodad(*obstacle);
+
+            rebuild.tile->BuildMesh(mesh);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+
+        // a newer mesh includes every obstacle of one not yet swapped in
+        if (error)
+        {
+            if (!rebuild.error)
+                rebuild.error = error;
+        }
+        else
+        {
+            rebuild.mesh = std::move(mesh);
+            rebuild.built = true;
+        }
+    }
+
+    rebuild.building = false;
+    m_tileRebuildDone.notify_all();
+}
+
+std::size_t Map::Update()
+{
+    std::vector<std::pair<int, int>> rebuilt;
+
+    // the first build to have failed.  it is rethrown only once the other
+    // rebuilds have been seen to, and the callbacks made
+    std::exception_ptr error;
+
+    for (auto i = m_tileRebuilds.begin(); i != m_tileRebuilds.end();)
+    {
+        auto& rebuild = i->second;
+
+        std::vector<std::uint8_t> mesh;
+        bool built;
+        bool finished;
+
+        {
+            std::lock_guard<std::mutex> guard(m_tileRebuildMutex);
+
+            built = rebuild.built;
+            rebuild.built = false;
+            mesh = std::move(rebuild.mesh);
+            rebuild.mesh.clear();
+
+            if (rebuild.error && !error)
+                error = rebuild.error;
+            rebuild.error = nullptr;
+
+            finished = !rebuild.building && rebuild.pending.empty();
+        }
+
+        if (built)
+        {
+            try
+            {
+                // this is the only point at which queries may observe the
+                // change, and it is brief
+                rebuild.tile->ReplaceMesh(std::move(mesh));
+                rebuilt.push_back(i->first);
+            }
+            catch (...)
+            {
+                // the old mesh remains
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+
+        if (finished)
+            i = m_tileRebuilds.erase(i);
+        else
+            ++i;
+    }
+
+    // the callback may add further game objects, so it is only called once
+    // the rebuilds have been left in a consistent state
+    if (m_tileRebuiltCallback)
+        for (auto const& coords : rebuilt)
+            m_tileRebuiltCallback(coords.first, coords.second);
+
+    if (error)
+        std::rethrow_exception(error);
+
+    return rebuilt.size();
+}
+
+void Map::WaitForTileRebuilds()
+{
+    // the callbacks made by Update() may add game objects, and so start
+    // further builds
+    while (!m_tileRebuilds.empty())
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_tileRebuildMutex);
+            m_tileRebuildDone.wait(lock,
+                                   [this]()
+                                   {
+                                       for (auto const& entry : m_tileRebuilds)
+                                           if (entry.second.building)
+                                               return false;
+
+                                       return true;
+                                   });
+        }
+
+        Update();
+    }
+}
+
+void Map::CancelTileRebuild(const std::pair<int, int>& coords)
+{
+    auto const rebuild = m_tileRebuilds.find(coords);
+
+    if (rebuild == m_tileRebuilds.end())
+        return;
+
+    {
+        // a running build stops after its current pass, and one not yet
+        // started finds nothing to do
+        std::unique_lock<std::mutex> lock(m_tileRebuildMutex);
+        rebuild->second.pending.clear();
+        m_tileRebuildDone.wait(lock, [&rebuild]()
+                               { return !rebuild->second.building; });
+    }
+
+    m_tileRebuilds.erase(rebuild);
+}
+
+void Map::PruneTemporaryObstacles()
+{
+    auto const expired = [this](std::uint64_t guid)
+    { return m_temporaryDoodads.at(guid).expired(); };
+
+    for (auto i = m_temporaryObstacleTiles.begin();
+         i != m_temporaryObstacleTiles.end();)
+    {
+        auto& guids = i->second;
+        guids.erase(std::remove_if(guids.begin(), guids.end(), expired),
+                    guids.end());
+
+        if (guids.empty())
+            i = m_temporaryObstacleTiles.erase(i);
+        else
+            ++i;
+    }
+
+    for (auto i = m_temporaryDoodads.begin(); i != m_temporaryDoodads.end();)
+    {
+        if (i->second.expired())
+            i = m_temporaryDoodads.erase(i);
+        else
+            ++i;
+    }
+}
+
+bool Map::AddTemporaryObstacles(Tile& tile)
+{
+    auto const obstacles = m_temporaryObstacleTiles.find({tile.m_x, tile.m_y});
+
+    if (obstacles == m_temporaryObstacleTiles.end())
+        return false;
+
+    auto result = false;
+
+    for (auto const guid : obstacles->second)
+    {
+        auto const doodad = m_temporaryDoodads.at(guid).lock();
+
+        if (!doodad || !tile.m_bounds.intersect2d(doodad->m_bounds))
+            continue;
+
+        tile.RasterizeTemporaryDoodad(guid, doodad);
+        result = true;
+    }
+
+    return result;
+}
+
+void Map::RebuildTiles(const std::vector<Tile*>& tiles)
+{
+    if (tiles.empty())
+        return;
+
+    std::vector<std::vector<std::uint8_t>> meshes(tiles.size());
+    std::atomic<std::size_t> next {0};
+
+    auto const work = [&tiles, &meshes, &next]()
+    {
+        for (auto i = next++; i < tiles.size(); i = next++)
+            tiles[i]->BuildMesh(meshes[i]);
+    };
+
+    auto const threads = (std::min)(
+        static_cast<std::size_t>(
+            (std::max)(1u, std::thread::hardware_concurrency())),
+        tiles.size());
+
+    // the calling thread takes a share of the work also
+    std::vector<std::future<void>> workers;
+    for (auto i = 1u; i < threads; ++i)
+        workers.push_back(std::async(std::launch::async, work));
+
+    work();
+
+    for (auto& worker : workers)
+        worker.get();
+
+    // the navmesh itself belongs to this thread
+    for (auto i = 0u; i < tiles.size(); ++i)
+        tiles[i]->ReplaceMesh(std::move(meshes[i]));
+}
+
 void Tile::AddTemporaryDoodad(std::uint64_t guid,
                               std::shared_ptr<DoodadInstance> doodad)
+{
+    RasterizeTemporaryDoodad(guid, std::move(doodad));
+
+    std::vector<std::uint8_t> data;
+    BuildMesh(data);
+    ReplaceMesh(std::move(data));
+}
+
+void Tile::RasterizeTemporaryDoodad(std::uint64_t guid,
+                                    std::shared_ptr<DoodadInstance> doodad)
+{
+    RasterizeDoodad(*doodad);
+    m_temporaryDoodads[guid] = std::move(doodad);
+}
+
+void Tile::RasterizeDoodad(const DoodadInstance& doodad)
 {
     if (!m_heightField.spans)
         LoadHeightField();
 
-    auto const model = doodad->m_model.lock();
+    auto const model = doodad.m_model.lock();
 
     std::vector<float> recastVertices;
-    math::Convert::VerticesToRecast(doodad->m_translatedVertices,
+    math::Convert::VerticesToRecast(doodad.m_translatedVertices,
                                     recastVertices);
 
-    std::vector<unsigned char> areas(model->m_aabbTree.Indices().size());
+    auto const indices = model->m_aabbTree.GetIndices();
 
-    m_temporaryDoodads[guid] = std::move(doodad);
+    std::vector<unsigned char> areas(indices.size());
 
     RecastContext ctx(rcLogCategory::RC_LOG_ERROR);
     rcClearUnwalkableTriangles(
         &ctx, MeshSettings::WalkableSlope, &recastVertices[0],
         static_cast<int>(recastVertices.size() / 3),
-        &model->m_aabbTree.Indices()[0],
-        static_cast<int>(model->m_aabbTree.Indices().size() / 3), &areas[0]);
+        &indices[0], static_cast<int>(indices.size() / 3), &areas[0]);
     rcRasterizeTriangles(
         &ctx, &recastVertices[0], static_cast<int>(recastVertices.size() / 3),
-        &model->m_aabbTree.Indices()[0], &areas[0],
-        static_cast<int>(model->m_aabbTree.Indices().size() / 3),
+        &indices[0], &areas[0], static_cast<int>(indices.size() / 3),
         m_heightField);
+}
+
+void Tile::BuildMesh(std::vector<std::uint8_t>& out)
+{
+    if (!m_heightField.spans)
+        LoadHeightField();
+
+    RecastContext ctx(rcLogCategory::RC_LOG_ERROR);
 
     // we don't want to filter ledge spans from ADT terrain.  this will restore
     // the area for these spans, which we are using for flags
@@ -357,19 +728,31 @@ void Tile::AddTemporaryDoodad(std::uint64_t guid,
 
     // build the mesh into a secondary buffer, rather than overwriting the
     // previous tile, so that we can delay the old tile's removal
-    std::vector<std::uint8_t> newTileData;
+    out.clear();
     auto const buildResult =
-        RebuildMeshTile(ctx, config, m_x, m_y, m_heightField, newTileData);
+        RebuildMeshTile(ctx, config, m_x, m_y, m_heightField, out);
     assert(buildResult);
+}
 
+void Tile::ReplaceMesh(std::vector<std::uint8_t>&& data)
+{
     if (m_ref)
     {
+        m_map->OnTileChanged(*this);
+
         auto const removeResult =
             m_map->m_navMesh.removeTile(m_ref, nullptr, nullptr);
         assert(removeResult == DT_SUCCESS);
     }
 
-    m_tileData = std::move(newTileData);
+    m_tileData = std::move(data);
+
+    // the obstacles may have left nothing navigable on the tile
+    if (m_tileData.empty())
+    {
+        m_ref = 0;
+        return;
+    }
 
     auto const insertResult = m_map->m_navMesh.addTile(
         &m_tileData[0], static_cast<int>(m_tileData.size()), 0, m_ref, &m_ref);
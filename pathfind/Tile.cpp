@@ -30,9 +30,9 @@ Tile::Tile(Map* map, utility::BinaryStream& in, const fs::path& navPath,
         in.ReadBytes(&m_staticWmos[0],
                      m_staticWmos.size() * sizeof(std::uint32_t));
 
-        for (auto const wmo : m_staticWmos)
-            m_staticWmoModels.push_back(
-                std::move(map->LoadModelForWmoInstance(wmo)));
+        // models are loaded when a query first reaches them
+        m_staticWmoModels.resize(wmoCount);
+        m_staticWmoDoodadSets.resize(wmoCount);
     }
 
     // for global WMOs, doodads are not referenced or loaded on a per-tile
@@ -46,9 +46,7 @@ Tile::Tile(Map* map, utility::BinaryStream& in, const fs::path& navPath,
         in.ReadBytes(&m_staticDoodads[0],
                      m_staticDoodads.size() * sizeof(std::uint32_t));
 
-        for (auto const doodad : m_staticDoodads)
-            m_staticDoodadModels.push_back(
-                std::move(map->LoadModelForDoodadInstance(doodad)));
+        m_staticDoodadModels.resize(doodadCount);
     }
 
     std::uint8_t quadHeight;
@@ -123,6 +121,8 @@ Tile::~Tile()
 {
     if (!!m_ref)
     {
+        m_map->OnTileChanged(*this);
+
         auto const result =
             m_map->m_navMesh.removeTile(m_ref, nullptr, nullptr);
         assert(result == DT_SUCCESS);
@@ -6,6 +6,7 @@
 #include "recastnavigation/Recast/Include/Recast.h"
 #include "utility/BinaryStream.hpp"
 #include "utility/BoundingBox.hpp"
+#include "utility/BoundingBoxArray.hpp"
 #include "utility/Ray.hpp"
 
 #include <cstdint>
@@ -42,9 +43,22 @@ public:
          bool load_heightfield = false);
     ~Tile();
 
+    // rasterizes the doodad into the height field and rebuilds the mesh
     void AddTemporaryDoodad(std::uint64_t guid,
                             std::shared_ptr<DoodadInstance> doodad);
 
+    // the steps of AddTemporaryDoodad(), so that many obstacles may be added
+    // to a tile with a single rebuild.  BuildMesh() touches nothing outside
+    // of this tile, and may run for different tiles in parallel.
+    // ReplaceMesh() swaps the result into the navmesh
+    void RasterizeTemporaryDoodad(std::uint64_t guid,
+                                  std::shared_ptr<DoodadInstance> doodad);
+    // rasterizes the doodad into the height field, without recording it on
+    // the tile.  like BuildMesh(), this touches nothing outside of the tile
+    void RasterizeDoodad(const DoodadInstance& doodad);
+    void BuildMesh(std::vector<std::uint8_t>& out);
+    void ReplaceMesh(std::vector<std::uint8_t>&& data);
+
     dtTileRef m_ref;
 
     math::BoundingBox m_bounds;
@@ -63,9 +77,23 @@ public:
     std::vector<std::uint32_t> m_staticWmos;
     std::vector<std::uint32_t> m_staticDoodads;
 
-    // park the shared pointers here just to increment their reference counts
-    std::vector<std::shared_ptr<WmoModel>> m_staticWmoModels;
-    std::vector<std::shared_ptr<DoodadModel>> m_staticDoodadModels;
+    // the instances above and their bounds, in the same order, filled in by
+    // the map once the tile is loaded.  rays are tested against the bounds
+    // of a whole tile at once, and only the instances they reach are visited
+    std::vector<const WmoInstance*> m_staticWmoInstances;
+    std::vector<const DoodadInstance*> m_staticDoodadInstances;
+    math::BoundingBoxArray m_staticWmoBounds;
+    math::BoundingBoxArray m_staticDoodadBounds;
+
+    // park the shared pointers here just to increment their reference counts.
+    // these parallel the instance ids above, and are null until the model is
+    // first needed
+    mutable std::vector<std::shared_ptr<const WmoModel>> m_staticWmoModels;
+    mutable std::vector<std::shared_ptr<const DoodadModel>>
+        m_staticDoodadModels;
+    // the doodad set used by each static wmo instance, null until its doodads
+    // are first needed
+    mutable std::vector<std::shared_ptr<const DoodadSet>> m_staticWmoDoodadSets;
 
     // indxed by GUID
     std::unordered_map<std::uint64_t, std::shared_ptr<WmoInstance>>
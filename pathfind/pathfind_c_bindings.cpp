@@ -1,5 +1,6 @@
 #include "pathfind_c_bindings.hpp"
 
+#include "ModelRepository.hpp"
 #include "utility/Exception.hpp"
 #include "utility/MathHelper.hpp"
 
@@ -198,6 +199,42 @@ PathfindResultType pathfind_find_point_in_between_vectors(pathfind::Map* const m
     }
 }
 
+PathfindResultType pathfind_move_along_surface(pathfind::Map* const map,
+                                               float start_x,
+                                               float start_y,
+                                               float start_z,
+                                               float stop_x,
+                                               float stop_y,
+                                               float stop_z,
+                                               uint8_t slide,
+                                               Vertex* const result,
+                                               Vertex* const hit_normal,
+                                               uint8_t* const blocked) {
+    try {
+        const math::Vertex start {start_x, start_y, start_z};
+        const math::Vertex stop {stop_x, stop_y, stop_z};
+
+        math::Vertex end_point {};
+        math::Vector3 normal {};
+        bool was_blocked;
+        if (!map->MoveAlongSurface(start, stop, end_point, normal, was_blocked, !!slide)) {
+            return static_cast<PathfindResultType>(Result::FAILED_TO_MOVE_ALONG_SURFACE);
+        }
+
+        *result = Vertex { end_point.X, end_point.Y, end_point.Z };
+        *hit_normal = Vertex { normal.X, normal.Y, normal.Z };
+        *blocked = was_blocked;
+
+        return static_cast<PathfindResultType>(Result::SUCCESS);
+    }
+    catch (utility::exception& e) {
+        return static_cast<PathfindResultType>(e.ResultCode());
+    }
+    catch (...) {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+}
+
 PathfindResultType pathfind_find_path(pathfind::Map* const map,
                float start_x,
                float start_y,
@@ -244,6 +281,301 @@ PathfindResultType pathfind_find_path(pathfind::Map* const map,
     }
 }
 
+PathfindResultType pathfind_find_path_with_precise_heights(pathfind::Map* const map,
+                                                           float start_x,
+                                                           float start_y,
+                                                           float start_z,
+                                                           float stop_x,
+                                                           float stop_y,
+                                                           float stop_z,
+                                                           Vertex* const buffer,
+                                                           unsigned int buffer_length,
+                                                           unsigned int* const amount_of_vertices)
+{
+    const math::Vertex start {start_x, start_y, start_z};
+    const math::Vertex stop {stop_x, stop_y, stop_z};
+
+    std::vector<math::Vertex> path;
+
+    try {
+        if (!map->FindPathWithPreciseHeights(start, stop, path)) {
+            return static_cast<PathfindResultType>(Result::UNKNOWN_PATH);
+        }
+
+        *amount_of_vertices = static_cast<unsigned int>(path.size());
+
+        if (path.size() > buffer_length) {
+            return static_cast<PathfindResultType>(Result::BUFFER_TOO_SMALL);
+        }
+
+        for (auto i = 0u; i < path.size(); ++i) {
+            buffer[i] = Vertex { path[i].X, path[i].Y, path[i].Z };
+        }
+
+        return static_cast<PathfindResultType>(Result::SUCCESS);
+    }
+    catch (utility::exception& e) {
+        return static_cast<PathfindResultType>(e.ResultCode());
+    }
+    catch (...) {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+}
+
+PathfindResultType pathfind_correct_heights(pathfind::Map* const map,
+                                            Vertex* const points,
+                                            unsigned int points_length)
+{
+    try {
+        std::vector<math::Vertex> vertices(points_length);
+
+        for (auto i = 0u; i < points_length; ++i) {
+            vertices[i] = {points[i].x, points[i].y, points[i].z};
+        }
+
+        map->CorrectHeights(vertices.data(), vertices.size());
+
+        for (auto i = 0u; i < points_length; ++i) {
+            points[i].z = vertices[i].Z;
+        }
+
+        return static_cast<PathfindResultType>(Result::SUCCESS);
+    }
+    catch (utility::exception& e) {
+        return static_cast<PathfindResultType>(e.ResultCode());
+    }
+    catch (...) {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+}
+
+PathfindResultType pathfind_resample_path(pathfind::Map* const map,
+                                          const Vertex* const path,
+                                          unsigned int path_length,
+                                          float step, uint8_t precise,
+                                          Vertex* const buffer,
+                                          unsigned int buffer_length,
+                                          unsigned int* const amount_of_vertices)
+{
+    try
+    {
+        std::vector<math::Vertex> input(path_length);
+
+        for (auto i = 0u; i < path_length; ++i) {
+            input[i] = {path[i].x, path[i].y, path[i].z};
+        }
+
+        std::vector<math::Vertex> output;
+        if (!map->ResamplePath(input, step, output, !!precise)) {
+            return static_cast<PathfindResultType>(Result::UNKNOWN_PATH);
+        }
+
+        *amount_of_vertices = static_cast<unsigned int>(output.size());
+
+        if (output.size() > buffer_length) {
+            return static_cast<PathfindResultType>(Result::BUFFER_TOO_SMALL);
+        }
+
+        for (auto i = 0u; i < output.size(); ++i) {
+            buffer[i] = Vertex { output[i].X, output[i].Y, output[i].Z };
+        }
+
+        return static_cast<PathfindResultType>(Result::SUCCESS);
+    }
+    catch (utility::exception& e)
+    {
+        return static_cast<PathfindResultType>(e.ResultCode());
+    }
+    catch (...)
+    {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+}
+
+PathfindResultType pathfind_simplify_path(pathfind::Map* const map,
+                                          Vertex* const path,
+                                          unsigned int* const path_length,
+                                          float height_tolerance)
+{
+    try
+    {
+        std::vector<math::Vertex> points(*path_length);
+
+        for (auto i = 0u; i < points.size(); ++i) {
+            points[i] = {path[i].x, path[i].y, path[i].z};
+        }
+
+        if (!map->SimplifyPath(points, height_tolerance)) {
+            return static_cast<PathfindResultType>(Result::UNKNOWN_PATH);
+        }
+
+        for (auto i = 0u; i < points.size(); ++i) {
+            path[i] = Vertex { points[i].X, points[i].Y, points[i].Z };
+        }
+
+        *path_length = static_cast<unsigned int>(points.size());
+
+        return static_cast<PathfindResultType>(Result::SUCCESS);
+    }
+    catch (utility::exception& e)
+    {
+        return static_cast<PathfindResultType>(e.ResultCode());
+    }
+    catch (...)
+    {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+}
+
+PathfindResultType pathfind_path_distance(pathfind::Map* const map,
+                                          float start_x, float start_y,
+                                          float start_z, float stop_x,
+                                          float stop_y, float stop_z,
+                                          float max_distance,
+                                          float* const distance)
+{
+    try
+    {
+        float result;
+        if (!map->PathDistance({start_x, start_y, start_z},
+                               {stop_x, stop_y, stop_z}, max_distance,
+                               result)) {
+            return static_cast<PathfindResultType>(Result::UNKNOWN_PATH);
+        }
+
+        *distance = result;
+
+        return static_cast<PathfindResultType>(Result::SUCCESS);
+    }
+    catch (utility::exception& e)
+    {
+        return static_cast<PathfindResultType>(e.ResultCode());
+    }
+    catch (...)
+    {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+}
+
+PathfindResultType pathfind_path_distances(pathfind::Map* const map,
+                                           float start_x, float start_y,
+                                           float start_z,
+                                           const Vertex* const stops,
+                                           unsigned int stops_length,
+                                           float max_distance,
+                                           float* const distances)
+{
+    try
+    {
+        std::vector<math::Vertex> ends(stops_length);
+
+        for (auto i = 0u; i < stops_length; ++i) {
+            ends[i] = {stops[i].x, stops[i].y, stops[i].z};
+        }
+
+        std::vector<float> result;
+        if (!map->PathDistances({start_x, start_y, start_z}, ends,
+                                max_distance, result)) {
+            return static_cast<PathfindResultType>(Result::UNKNOWN_PATH);
+        }
+
+        for (auto i = 0u; i < stops_length; ++i) {
+            distances[i] = result[i];
+        }
+
+        return static_cast<PathfindResultType>(Result::SUCCESS);
+    }
+    catch (utility::exception& e)
+    {
+        return static_cast<PathfindResultType>(e.ResultCode());
+    }
+    catch (...)
+    {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+}
+
+PathfindResultType pathfind_polys_within_path_distance(pathfind::Map* const map,
+                                                       float x, float y,
+                                                       float z, float radius,
+                                                       PolyDistance* const buffer,
+                                                       unsigned int buffer_length,
+                                                       unsigned int* const amount_of_polys)
+{
+    try
+    {
+        pathfind::PolyDistances polys;
+        if (!map->PolysWithinPathDistance({x, y, z}, radius, polys)) {
+            return static_cast<PathfindResultType>(Result::UNKNOWN_PATH);
+        }
+
+        *amount_of_polys = static_cast<unsigned int>(polys.size());
+
+        if (polys.size() > buffer_length) {
+            return static_cast<PathfindResultType>(Result::BUFFER_TOO_SMALL);
+        }
+
+        for (auto i = 0u; i < polys.size(); ++i) {
+            auto const& entry = polys[i].entry;
+            buffer[i] = PolyDistance { polys[i].poly, polys[i].distance,
+                                       Vertex { entry.X, entry.Y, entry.Z } };
+        }
+
+        return static_cast<PathfindResultType>(Result::SUCCESS);
+    }
+    catch (utility::exception& e)
+    {
+        return static_cast<PathfindResultType>(e.ResultCode());
+    }
+    catch (...)
+    {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+}
+
+PathfindResultType pathfind_distances_from_poly_set(pathfind::Map* const map,
+                                                    const PolyDistance* const polys,
+                                                    unsigned int polys_length,
+                                                    float radius,
+                                                    const Vertex* const positions,
+                                                    unsigned int positions_length,
+                                                    float* const distances)
+{
+    try
+    {
+        pathfind::PolyDistances set(polys_length);
+
+        for (auto i = 0u; i < polys_length; ++i) {
+            auto const& entry = polys[i].entry;
+            set[i] = {polys[i].poly, polys[i].distance,
+                      {entry.x, entry.y, entry.z}};
+        }
+
+        std::vector<math::Vertex> vertices(positions_length);
+
+        for (auto i = 0u; i < positions_length; ++i) {
+            vertices[i] = {positions[i].x, positions[i].y, positions[i].z};
+        }
+
+        std::vector<float> result;
+        map->DistancesFromPolySet(set, radius, vertices, result);
+
+        for (auto i = 0u; i < positions_length; ++i) {
+            distances[i] = result[i];
+        }
+
+        return static_cast<PathfindResultType>(Result::SUCCESS);
+    }
+    catch (utility::exception& e)
+    {
+        return static_cast<PathfindResultType>(e.ResultCode());
+    }
+    catch (...)
+    {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+}
+
 PathfindResultType pathfind_find_heights(pathfind::Map* const map,
                   float x,
                   float y,
@@ -329,6 +661,77 @@ PathfindResultType pathfind_line_of_sight(pathfind::Map* map,
     }
 }
 
+PathfindResultType pathfind_line_of_sight_navmesh_first(pathfind::Map* map,
+                                                        float start_x, float start_y, float start_z,
+                                                        float stop_x, float stop_y, float stop_z,
+                                                        uint8_t* const line_of_sight, uint8_t doodads) {
+    try
+    {
+        if (map->LineOfSight({start_x, start_y, start_z}, {stop_x, stop_y, stop_z}, doodads, true)) {
+            *line_of_sight = 1;
+        } else {
+            *line_of_sight = 0;
+        }
+
+        return static_cast<PathfindResultType>(Result::SUCCESS);
+    }
+    catch (utility::exception& e)
+    {
+        return static_cast<PathfindResultType>(e.ResultCode());
+    }
+    catch (...)
+    {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+}
+
+PathfindResultType pathfind_warm_up_models(pathfind::Map* const map,
+                                           float x,
+                                           float y,
+                                           float z,
+                                           float radius,
+                                           unsigned int* const models_loaded) {
+    try {
+        *models_loaded = static_cast<unsigned int>(map->WarmUpModels({x, y, z}, radius));
+
+        return static_cast<PathfindResultType>(Result::SUCCESS);
+    }
+    catch (utility::exception& e) {
+        return static_cast<PathfindResultType>(e.ResultCode());
+    }
+    catch (...) {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+}
+
+PathfindResultType pathfind_model_memory_usage(uint64_t* const bytes) {
+    try {
+        *bytes = static_cast<uint64_t>(pathfind::ModelRepository::Instance().MemoryUsage());
+
+        return static_cast<PathfindResultType>(Result::SUCCESS);
+    }
+    catch (utility::exception& e) {
+        return static_cast<PathfindResultType>(e.ResultCode());
+    }
+    catch (...) {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+}
+
+PathfindResultType pathfind_set_quantize_models(uint8_t quantize) {
+    try {
+        pathfind::ModelRepository::Instance().SetQuantizeModels(quantize != 0);
+
+        return static_cast<PathfindResultType>(Result::SUCCESS);
+    }
+    catch (utility::exception& e) {
+        return static_cast<PathfindResultType>(e.ResultCode());
+    }
+    catch (...) {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+}
+
 PathfindResultType pathfind_find_random_point_around_circle(pathfind::Map* const map,
                                                             float x,
                                                             float y,
@@ -363,4 +766,161 @@ PathfindResultType pathfind_find_random_point_around_circle(pathfind::Map* const
     }
 }
 
+PathfindResultType pathfind_build_flow_field(pathfind::Map* const map,
+                                             float x, float y, float z,
+                                             float max_cost) {
+    try
+    {
+        if (!map->BuildFlowField({x, y, z}, max_cost)) {
+            return static_cast<PathfindResultType>(Result::FAILED_TO_BUILD_FLOW_FIELD);
+        }
+
+        return static_cast<PathfindResultType>(Result::SUCCESS);
+    }
+    catch (utility::exception& e)
+    {
+        return static_cast<PathfindResultType>(e.ResultCode());
+    }
+    catch (...)
+    {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+}
+
+PathfindResultType pathfind_clear_flow_fields(pathfind::Map* const map) {
+    try
+    {
+        map->ClearFlowFields();
+    }
+    catch (utility::exception& e)
+    {
+        return static_cast<PathfindResultType>(e.ResultCode());
+    }
+    catch (...)
+    {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+
+    return static_cast<PathfindResultType>(Result::SUCCESS);
+}
+
+PathfindResultType pathfind_build_path_oracle(pathfind::Map* const map,
+                                              unsigned int max_polys) {
+    try
+    {
+        if (!map->BuildPathOracle(max_polys)) {
+            return static_cast<PathfindResultType>(Result::FAILED_TO_BUILD_PATH_ORACLE);
+        }
+
+        return static_cast<PathfindResultType>(Result::SUCCESS);
+    }
+    catch (utility::exception& e)
+    {
+        return static_cast<PathfindResultType>(e.ResultCode());
+    }
+    catch (...)
+    {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+}
+
+PathfindResultType pathfind_get_statistics(pathfind::Map* const map,
+                                           PathfindStatistics* const statistics) {
+    auto const& stats = map->GetStatistics();
+
+    statistics->path_queries = stats.pathQueries;
+    statistics->direct_paths = stats.directPaths;
+    statistics->path_cache_hits = stats.pathCacheHits;
+    statistics->path_cache_misses = stats.pathCacheMisses;
+    statistics->line_of_sight_cache_hits = stats.lineOfSightCacheHits;
+    statistics->line_of_sight_cache_misses = stats.lineOfSightCacheMisses;
+    statistics->line_of_sight_queries = stats.lineOfSightQueries;
+    statistics->navmesh_line_of_sights = stats.navMeshLineOfSights;
+    statistics->flow_field_hits = stats.flowFieldHits;
+
+    return static_cast<PathfindResultType>(Result::SUCCESS);
+}
+
+PathfindResultType pathfind_set_path_cache_capacity(pathfind::Map* const map,
+                                                    unsigned int capacity) {
+    try {
+        map->SetPathCacheCapacity(capacity);
+
+        return static_cast<PathfindResultType>(Result::SUCCESS);
+    }
+    catch (...) {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+}
+
+PathfindResultType pathfind_clear_path_cache(pathfind::Map* const map) {
+    map->ClearPathCache();
+
+    return static_cast<PathfindResultType>(Result::SUCCESS);
+}
+
+PathfindResultType pathfind_set_line_of_sight_cache_capacity(pathfind::Map* const map,
+                                                             unsigned int capacity) {
+    try {
+        map->SetLineOfSightCacheCapacity(capacity);
+
+        return static_cast<PathfindResultType>(Result::SUCCESS);
+    }
+    catch (...) {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+}
+
+PathfindResultType pathfind_clear_line_of_sight_cache(pathfind::Map* const map) {
+    map->ClearLineOfSightCache();
+
+    return static_cast<PathfindResultType>(Result::SUCCESS);
+}
+
+PathfindResultType pathfind_reset_statistics(pathfind::Map* const map) {
+    map->ResetStatistics();
+
+    return static_cast<PathfindResultType>(Result::SUCCESS);
+}
+
+PathfindResultType pathfind_find_random_points_around_circle(pathfind::Map* const map,
+                                                             float x,
+                                                             float y,
+                                                             float z,
+                                                             float radius,
+                                                             Vertex* const buffer,
+                                                             unsigned int buffer_length,
+                                                             unsigned int* const amount_of_points) {
+    try
+    {
+        std::vector<math::Vertex> points;
+
+        if (!map->FindRandomPointsAroundCircle({x, y, z}, radius, buffer_length, points)) {
+            return static_cast<PathfindResultType>(Result::UNABLE_TO_FIND_RANDOM_POINT_IN_CIRCLE);
+        }
+
+        for (auto i = 0u; i < points.size(); ++i) {
+            buffer[i] = Vertex { points[i].X, points[i].Y, points[i].Z };
+        }
+
+        *amount_of_points = static_cast<unsigned int>(points.size());
+
+        return static_cast<PathfindResultType>(Result::SUCCESS);
+    }
+    catch (utility::exception& e)
+    {
+        return static_cast<PathfindResultType>(e.ResultCode());
+    }
+    catch (...)
+    {
+        return static_cast<PathfindResultType>(Result::UNKNOWN_EXCEPTION);
+    }
+}
+
+PathfindResultType pathfind_seed_random(pathfind::Map* const map, uint64_t seed) {
+    map->SeedRandom(seed);
+
+    return static_cast<PathfindResultType>(Result::SUCCESS);
+}
+
 } // extern "C"
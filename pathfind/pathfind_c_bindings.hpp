@@ -10,6 +10,24 @@ typedef struct {
     float z;
 } Vertex;
 
+typedef struct {
+    uint64_t poly;
+    float distance;
+    Vertex entry;
+} PolyDistance;
+
+typedef struct {
+    uint64_t path_queries;
+    uint64_t direct_paths;
+    uint64_t path_cache_hits;
+    uint64_t path_cache_misses;
+    uint64_t line_of_sight_cache_hits;
+    uint64_t line_of_sight_cache_misses;
+    uint64_t line_of_sight_queries;
+    uint64_t navmesh_line_of_sights;
+    uint64_t flow_field_hits;
+} PathfindStatistics;
+
 typedef uint8_t PathfindResultType;
 typedef uint8_t* PathfindResultTypePtr;
 
@@ -86,6 +104,28 @@ PathfindResultType pathfind_find_point_in_between_vectors(pathfind::Map* const m
                                                           float z2,
                                                           Vertex* out_vertex);
 
+/*
+    Moves from `start_x`, `start_y`, and `start_z` toward `stop_x`, `stop_y`,
+    and `stop_z` along the navmesh, as for a charge, blink or knockback.
+
+    The farthest point reached is written to `result`, with a precise height.
+    If a wall was hit, `blocked` is set to 1 and its normal is written to
+    `hit_normal`, otherwise `blocked` is set to 0 and `hit_normal` is zero.
+    If `slide` is non zero, the movement continues along a wall rather than
+    stopping at it.
+*/
+PathfindResultType pathfind_move_along_surface(pathfind::Map* const map,
+                                               float start_x,
+                                               float start_y,
+                                               float start_z,
+                                               float stop_x,
+                                               float stop_y,
+                                               float stop_z,
+                                               uint8_t slide,
+                                               Vertex* const result,
+                                               Vertex* const hit_normal,
+                                               uint8_t* const blocked);
+
 /*
     Calculates a path from `start_x`, `start_y`, and `start_z` to
     `stop_x`, `stop_y`, and `stop_z`.
@@ -97,6 +137,122 @@ PathfindResultType pathfind_find_path(pathfind::Map* const map, float start_x,
                                       unsigned int buffer_length,
                                       unsigned int* const amount_of_vertices);
 
+/*
+    Cuts the `path_length` points of `path` into points `step` apart, at the
+    height of the navmesh.
+
+    If `precise` is not `0`, heights are also refined against the collision
+    geometry.  If `buffer` is too small, `amount_of_vertices` is set to the
+    required length and `BUFFER_TOO_SMALL` is returned.
+*/
+PathfindResultType pathfind_resample_path(pathfind::Map* const map,
+                                          const Vertex* const path,
+                                          unsigned int path_length,
+                                          float step, uint8_t precise,
+                                          Vertex* const buffer,
+                                          unsigned int buffer_length,
+                                          unsigned int* const amount_of_vertices);
+
+/*
+    Removes points from the `path_length` points of `path`, in place, where a
+    straight line along the navmesh joins their neighbours and the removed
+    points lie within `height_tolerance` of the height of that line.
+
+    `path_length` is updated to the new length.
+*/
+PathfindResultType pathfind_simplify_path(pathfind::Map* const map,
+                                          Vertex* const path,
+                                          unsigned int* const path_length,
+                                          float height_tolerance);
+
+/*
+    Calculates the walking distance from `start_x`, `start_y`, and `start_z`
+    to `stop_x`, `stop_y`, and `stop_z`, without producing the path.
+
+    The search gives up once the distance is known to exceed `max_distance`,
+    in which case `UNKNOWN_PATH` is returned.
+*/
+PathfindResultType pathfind_path_distance(pathfind::Map* const map,
+                                          float start_x, float start_y,
+                                          float start_z, float stop_x,
+                                          float stop_y, float stop_z,
+                                          float max_distance,
+                                          float* const distance);
+
+/*
+    Calculates the walking distance from `start_x`, `start_y`, and `start_z`
+    to each of the `stops_length` points in `stops`, writing them to
+    `distances`, which must be at least as long.
+
+    Distances greater than `max_distance`, or to unreachable points, are set
+    to infinity.
+*/
+PathfindResultType pathfind_path_distances(pathfind::Map* const map,
+                                           float start_x, float start_y,
+                                           float start_z,
+                                           const Vertex* const stops,
+                                           unsigned int stops_length,
+                                           float max_distance,
+                                           float* const distances);
+
+/*
+    Finds every navmesh poly which can be reached by walking no more than
+    `radius` from `x`, `y`, and `z`, along with the distance to the point at
+    which each is entered, and that point.
+
+    The result is meant to be passed to `pathfind_distances_from_poly_set`.
+    If `buffer` is too small, `amount_of_polys` is set to the required length
+    and `BUFFER_TOO_SMALL` is returned.
+*/
+PathfindResultType pathfind_polys_within_path_distance(pathfind::Map* const map,
+                                                       float x, float y,
+                                                       float z, float radius,
+                                                       PolyDistance* const buffer,
+                                                       unsigned int buffer_length,
+                                                       unsigned int* const amount_of_polys);
+
+/*
+    Writes the walking distance to each of the `positions_length` points in
+    `positions` to `distances`, using the `polys_length` entries of `polys`
+    found by `pathfind_polys_within_path_distance` for `radius`.
+
+    Positions outside of the set, or further than `radius`, are given
+    infinite distance.
+*/
+PathfindResultType pathfind_distances_from_poly_set(pathfind::Map* const map,
+                                                    const PolyDistance* const polys,
+                                                    unsigned int polys_length,
+                                                    float radius,
+                                                    const Vertex* const positions,
+                                                    unsigned int positions_length,
+                                                    float* const distances);
+
+/*
+    As `pathfind_find_path`, but with the height of every point corrected
+    against the collision geometry.
+*/
+PathfindResultType pathfind_find_path_with_precise_heights(pathfind::Map* const map,
+                                                           float start_x,
+                                                           float start_y,
+                                                           float start_z,
+                                                           float stop_x,
+                                                           float stop_y,
+                                                           float stop_z,
+                                                           Vertex* const buffer,
+                                                           unsigned int buffer_length,
+                                                           unsigned int* const amount_of_vertices);
+
+/*
+    Corrects the height of each of the `points_length` points in `points`
+    against the collision geometry, in place.
+
+    The points must already lie on or slightly above the navmesh, such as
+    those returned by `pathfind_find_path`.
+*/
+PathfindResultType pathfind_correct_heights(pathfind::Map* const map,
+                                            Vertex* const points,
+                                            unsigned int points_length);
+
 /*
     Slices the map at `x`, `y` and returns all possible `z` values.
 */
@@ -126,6 +282,43 @@ PathfindResultType pathfind_line_of_sight(pathfind::Map* const map,
                                           float stop_x, float stop_y, float stop_z,
                                           uint8_t* const line_of_sight, uint8_t doodads);
 
+/*
+    As `pathfind_line_of_sight`, but checks between the feet of nearby units
+    are first attempted with a ray cast along the navmesh, which is much
+    cheaper when it succeeds.  The collision geometry is used when the navmesh
+    cannot decide.
+*/
+PathfindResultType pathfind_line_of_sight_navmesh_first(pathfind::Map* const map,
+                                                        float start_x, float start_y, float start_z,
+                                                        float stop_x, float stop_y, float stop_z,
+                                                        uint8_t* const line_of_sight, uint8_t doodads);
+
+/*
+    Loads the collision models of every instance on a loaded ADT within
+    `radius` of `x`, `y`, and `z`, writing the number loaded to
+    `models_loaded`.  Models are otherwise loaded by the first query to
+    reach them.
+*/
+PathfindResultType pathfind_warm_up_models(pathfind::Map* const map,
+                                           float x,
+                                           float y,
+                                           float z,
+                                           float radius,
+                                           unsigned int* const models_loaded);
+
+/*
+    Writes the number of bytes held by the collision models shared between
+    every loaded map to `bytes`.
+*/
+PathfindResultType pathfind_model_memory_usage(uint64_t* const bytes);
+
+/*
+    When `quantize` is nonzero, collision models loaded from now on by any map
+    are quantized, roughly halving their memory at a small cost to line of
+    sight and height queries.
+*/
+PathfindResultType pathfind_set_quantize_models(uint8_t quantize);
+
 /*
     Returns a random point within `radius` of `x`, `y`, and `z`.
 */
@@ -138,5 +331,97 @@ PathfindResultType pathfind_find_random_point_around_circle(pathfind::Map* const
                                                             float* const random_y,
                                                             float* const random_z);
 
+/*
+    Builds a flow field toward `x`, `y`, `z`, covering every point from which
+    the target can be reached for no more than `max_cost`.
+
+    Later calls to `pathfind_find_path` ending at the same target will follow
+    the field instead of running a new search.
+*/
+PathfindResultType pathfind_build_flow_field(pathfind::Map* const map,
+                                             float x, float y, float z,
+                                             float max_cost);
+
+/*
+    Drops all flow fields built by `pathfind_build_flow_field`.
+*/
+PathfindResultType pathfind_clear_flow_fields(pathfind::Map* const map);
+
+/*
+    Precomputes the next hop between every pair of polys on a global WMO map
+    with no more than `max_polys` polys, and saves it alongside the map data.
+
+    The table is loaded automatically by `pathfind_new_map` from then on.
+*/
+PathfindResultType pathfind_build_path_oracle(pathfind::Map* const map,
+                                              unsigned int max_polys);
+
+/*
+    Returns counters for the queries made against the map.
+
+    `direct_paths` counts the `pathfind_find_path` calls answered by a
+    straight line, with no search.  `path_cache_hits` and
+    `path_cache_misses` count the calls which consulted the path cache.
+    `line_of_sight_cache_hits` and `line_of_sight_cache_misses` do the same
+    for `pathfind_line_of_sight`.  `navmesh_line_of_sights` counts the
+    `line_of_sight_queries` answered by the navmesh alone.
+    `flow_field_hits` counts the `pathfind_find_path` calls whose corridor
+    was read from a flow field built by `pathfind_build_flow_field`.
+*/
+PathfindResultType pathfind_get_statistics(pathfind::Map* const map,
+                                           PathfindStatistics* const statistics);
+
+/*
+    Caches the results of up to `capacity` recent path searches, keyed by
+    start and end poly.  Entries are discarded when a tile they cross is
+    unloaded or changed by a game object.  Zero, the default, disables the
+    cache.
+*/
+PathfindResultType pathfind_set_path_cache_capacity(pathfind::Map* const map,
+                                                    unsigned int capacity);
+
+/*
+    Discards every entry in the path cache.
+*/
+PathfindResultType pathfind_clear_path_cache(pathfind::Map* const map);
+
+/*
+    Caches up to `capacity` recent `pathfind_line_of_sight` results, matching
+    endpoints to within a few centimetres.  Entries are discarded when a game
+    object is added near them, and the cache is cleared when an ADT is loaded
+    or unloaded.  Zero, the default, disables the cache.
+*/
+PathfindResultType pathfind_set_line_of_sight_cache_capacity(pathfind::Map* const map,
+                                                             unsigned int capacity);
+
+/*
+    Discards every entry in the line of sight cache.
+*/
+PathfindResultType pathfind_clear_line_of_sight_cache(pathfind::Map* const map);
+
+/*
+    Resets all query counters to zero.
+*/
+PathfindResultType pathfind_reset_statistics(pathfind::Map* const map);
+
+/*
+    Writes up to `buffer_length` random points within `radius` of `x`, `y`,
+    and `z` to `buffer`, and the number written to `amount_of_points`.
+*/
+PathfindResultType pathfind_find_random_points_around_circle(pathfind::Map* const map,
+                                                             float x,
+                                                             float y,
+                                                             float z,
+                                                             float radius,
+                                                             Vertex* const buffer,
+                                                             unsigned int buffer_length,
+                                                             unsigned int* const amount_of_points);
+
+/*
+    Seeds the generator used by random point queries on this map, making
+    their results reproducible.
+*/
+PathfindResultType pathfind_seed_random(pathfind::Map* const map, uint64_t seed);
+
 } // extern "C"
 
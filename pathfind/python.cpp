@@ -1,12 +1,15 @@
 #include "Map.hpp"
+#include "ModelRepository.hpp"
 #include "utility/MathHelper.hpp"
 
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <cmath>
 #include <memory>
 #include <string>
 #include <thread>
+#include <tuple>
 #include <vector>
 #include <optional>
 
@@ -16,7 +19,7 @@ namespace
 {
 py::list python_find_path(const pathfind::Map& map, float start_x,
                           float start_y, float start_z, float stop_x,
-                          float stop_y, float stop_z)
+                          float stop_y, float stop_z, bool precise_heights)
 {
     py::list result;
 
@@ -25,7 +28,11 @@ py::list python_find_path(const pathfind::Map& map, float start_x,
 
     std::vector<math::Vertex> path;
 
-    if (map.FindPath(start, stop, path))
+    auto const found = precise_heights
+                           ? map.FindPathWithPreciseHeights(start, stop, path)
+                           : map.FindPath(start, stop, path);
+
+    if (found)
         for (auto const& point : path)
             result.append(py::make_tuple(point.X, point.Y, point.Z));
 
@@ -93,12 +100,13 @@ std::optional<float> python_query_z(const pathfind::Map& map, float start_x, flo
 }
 
 bool los(const pathfind::Map& map, float start_x, float start_y, float start_z,
-         float stop_x, float stop_y, float stop_z, bool doodads)
+         float stop_x, float stop_y, float stop_z, bool doodads,
+         bool navmesh_first)
 {
     return map.LineOfSight(
             {start_x, start_y, start_z},
             {stop_x, stop_y, stop_z},
-            doodads);
+            doodads, navmesh_first);
 }
 
 py::object get_zone_and_area(pathfind::Map& map, float x, float y, float z)
@@ -133,10 +141,238 @@ py::object find_random_point_around_circle(pathfind::Map& map, float x, float y,
     return py::make_tuple(random_point.X, random_point.Y, random_point.Z);
 }
 
+py::object move_along_surface(const pathfind::Map& map, float start_x,
+                              float start_y, float start_z, float stop_x,
+                              float stop_y, float stop_z, bool slide)
+{
+    math::Vertex result;
+    math::Vector3 hit_normal;
+    bool blocked;
+
+    if (!map.MoveAlongSurface({start_x, start_y, start_z},
+                              {stop_x, stop_y, stop_z}, result, hit_normal,
+                              blocked, slide))
+        return py::none();
+
+    py::object normal = py::none();
+    if (blocked)
+        normal = py::make_tuple(hit_normal.X, hit_normal.Y, hit_normal.Z);
+
+    return py::make_tuple(py::make_tuple(result.X, result.Y, result.Z),
+                          normal);
+}
+
+int warm_up_models(pathfind::Map& map, float x, float y, float z,
+                   float radius)
+{
+    return map.WarmUpModels({x, y, z}, radius);
+}
+
+bool build_flow_field(pathfind::Map& map, float x, float y, float z,
+                      float max_cost)
+{
+    return map.BuildFlowField({x, y, z}, max_cost);
+}
+
+std::optional<float> path_distance(const pathfind::Map& map, float start_x,
+                                   float start_y, float start_z, float stop_x,
+                                   float stop_y, float stop_z,
+                                   float max_distance)
+{
+    float distance;
+    if (!map.PathDistance({start_x, start_y, start_z}, {stop_x, stop_y, stop_z},
+                          max_distance, distance))
+        return {};
+    return distance;
+}
+
+std::vector<std::optional<float>>
+path_distances(const pathfind::Map& map, float start_x, float start_y,
+               float start_z,
+               const std::vector<std::tuple<float, float, float>>& stops,
+               float max_distance)
+{
+    std::vector<math::Vertex> ends;
+    ends.reserve(stops.size());
+
+    for (auto const& stop : stops)
+        ends.push_back({std::get<0>(stop), std::get<1>(stop), std::get<2>(stop)});
+
+    std::vector<float> distances;
+    std::vector<std::optional<float>> result(stops.size());
+
+    if (map.PathDistances({start_x, start_y, start_z}, ends, max_distance,
+                          distances))
+        for (auto i = 0u; i < distances.size(); ++i)
+            if (distances[i] <= max_distance)
+                result[i] = distances[i];
+
+    return result;
+}
+
+// (poly, distance, (x, y, z) of the point at which the poly is entered)
+using PolySetEntry =
+    std::tuple<dtPolyRef, float, std::tuple<float, float, float>>;
+
+std::vector<PolySetEntry> polys_within_path_distance(const pathfind::Map& map,
+                                                     float x, float y, float z,
+                                                     float radius)
+{
+    pathfind::PolyDistances polys;
+    map.PolysWithinPathDistance({x, y, z}, radius, polys);
+
+    std::vector<PolySetEntry> result;
+    result.reserve(polys.size());
+
+    for (auto const& poly : polys)
+        result.emplace_back(
+            poly.poly, poly.distance,
+            std::make_tuple(poly.entry.X, poly.entry.Y, poly.entry.Z));
+
+    return result;
+}
+
+std::vector<std::optional<float>> distances_from_poly_set(
+    const pathfind::Map& map, const std::vector<PolySetEntry>& entries,
+    float radius, const std::vector<std::tuple<float, float, float>>& positions)
+{
+    pathfind::PolyDistances polys;
+    polys.reserve(entries.size());
+
+    for (auto const& entry : entries)
+    {
+        auto const& point = std::get<2>(entry);
+        polys.push_back({std::get<0>(entry), std::get<1>(entry),
+                         {std::get<0>(point), std::get<1>(point),
+                          std::get<2>(point)}});
+    }
+
+    std::vector<math::Vertex> vertices;
+    vertices.reserve(positions.size());
+
+    for (auto const& position : positions)
+        vertices.push_back({std::get<0>(position), std::get<1>(position),
+                            std::get<2>(position)});
+
+    std::vector<float> distances;
+    map.DistancesFromPolySet(polys, radius, vertices, distances);
+
+    std::vector<std::optional<float>> result(distances.size());
+
+    for (auto i = 0u; i < distances.size(); ++i)
+        if (std::isfinite(distances[i]))
+            result[i] = distances[i];
+
+    return result;
+}
+
+py::dict statistics(const pathfind::Map& map)
+{
+    auto const& stats = map.GetStatistics();
+
+    py::dict result;
+    result["path_queries"] = stats.pathQueries;
+    result["direct_paths"] = stats.directPaths;
+    result["flow_field_hits"] = stats.flowFieldHits;
+    result["path_cache_hits"] = stats.pathCacheHits;
+    result["path_cache_misses"] = stats.pathCacheMisses;
+    result["line_of_sight_cache_hits"] = stats.lineOfSightCacheHits;
+    result["line_of_sight_cache_misses"] = stats.lineOfSightCacheMisses;
+    result["line_of_sight_queries"] = stats.lineOfSightQueries;
+    result["navmesh_line_of_sights"] = stats.navMeshLineOfSights;
+
+    return result;
+}
+
+py::list find_random_points_around_circle(const pathfind::Map& map, float x,
+                                          float y, float z, float radius,
+                                          unsigned int count)
+{
+    py::list result;
+
+    std::vector<math::Vertex> points;
+
+    if (map.FindRandomPointsAroundCircle({x, y, z}, radius, count, points))
+        for (auto const& point : points)
+            result.append(py::make_tuple(point.X, point.Y, point.Z));
+
+    return result;
+}
+
+py::list resample_path(const pathfind::Map& map,
+                       const std::vector<std::tuple<float, float, float>>& path,
+                       float step, bool precise)
+{
+    py::list result;
+
+    std::vector<math::Vertex> input;
+    input.reserve(path.size());
+
+    for (auto const& point : path)
+        input.push_back({std::get<0>(point), std::get<1>(point), std::get<2>(point)});
+
+    std::vector<math::Vertex> output;
+
+    if (map.ResamplePath(input, step, output, precise))
+        for (auto const& point : output)
+            result.append(py::make_tuple(point.X, point.Y, point.Z));
+
+    return result;
+}
+
+py::list simplify_path(const pathfind::Map& map,
+                       const std::vector<std::tuple<float, float, float>>& path,
+                       float height_tolerance)
+{
+    py::list result;
+
+    std::vector<math::Vertex> points;
+    points.reserve(path.size());
+
+    for (auto const& point : path)
+        points.push_back({std::get<0>(point), std::get<1>(point), std::get<2>(point)});
+
+    if (map.SimplifyPath(points, height_tolerance))
+        for (auto const& point : points)
+            result.append(py::make_tuple(point.X, point.Y, point.Z));
+
+    return result;
+}
+
+py::list correct_heights(const pathfind::Map& map,
+                         const std::vector<std::tuple<float, float, float>>& points)
+{
+    py::list result;
+
+    std::vector<math::Vertex> vertices;
+    vertices.reserve(points.size());
+
+    for (auto const& point : points)
+        vertices.push_back({std::get<0>(point), std::get<1>(point), std::get<2>(point)});
+
+    map.CorrectHeights(vertices.data(), vertices.size());
+
+    for (auto const& vertex : vertices)
+        result.append(py::make_tuple(vertex.X, vertex.Y, vertex.Z));
+
+    return result;
+}
+
 } // namespace
 
 PYBIND11_MODULE(pathfind, m)
 {
+    m.def("model_memory_usage",
+        []() { return pathfind::ModelRepository::Instance().MemoryUsage(); },
+        "Returns the number of bytes held by the collision models shared between every loaded map."
+    );
+
+    m.def("set_quantize_models",
+        [](bool quantize) { pathfind::ModelRepository::Instance().SetQuantizeModels(quantize); },
+        "Quantizes the collision models loaded from now on, which roughly halves their memory at a small cost to line of sight and height queries.",
+        py::arg("quantize")
+    );
+
     py::class_<pathfind::Map>(m, "Map")
         .def(py::init<const std::string&, const std::string&>(),
             py::arg("data_path"),
@@ -165,13 +401,82 @@ This may take a while depending on the map size.)del"
            &python_find_path,
            R"del(Attempts to find a path between `start` and `stop`.
 
-Returns a list of points if a path was found, otherwise an empty list.)del",
+Returns a list of points if a path was found, otherwise an empty list.
+If `precise_heights` is `True`, the height of every point is corrected against the collision geometry.)del",
            py::arg("start_x"),
            py::arg("start_y"),
            py::arg("start_z"),
            py::arg("stop_x"),
            py::arg("stop_y"),
-           py::arg("stop_z")
+           py::arg("stop_z"),
+           py::arg("precise_heights") = false
+        )
+        .def("correct_heights",
+            &correct_heights,
+            R"del(Corrects the height of each `(x, y, z)` tuple in `points` against the collision geometry.
+
+The points must already lie on or slightly above the navmesh, such as those returned by `find_path`.)del",
+            py::arg("points")
+        )
+        .def("resample_path",
+            &resample_path,
+            R"del(Cuts `path`, a list of `(x, y, z)` tuples such as one returned by `find_path`, into points `step` apart at the height of the navmesh.
+
+If `precise` is `True`, heights are also refined against the collision geometry.)del",
+            py::arg("path"),
+            py::arg("step"),
+            py::arg("precise") = false
+        )
+        .def("simplify_path",
+            &simplify_path,
+            R"del(Removes points from `path`, a list of `(x, y, z)` tuples such as one returned by `find_path`, where a straight line along the navmesh joins their neighbours.
+
+Points are only removed if they lie within `height_tolerance` of the height of that line.)del",
+            py::arg("path"),
+            py::arg("height_tolerance")
+        )
+        .def("path_distance",
+            &path_distance,
+            R"del(Returns the walking distance between `start` and `stop`, without computing the path itself.
+
+Returns `None` if there is no path, or if the distance is greater than `max_distance`.)del",
+            py::arg("start_x"),
+            py::arg("start_y"),
+            py::arg("start_z"),
+            py::arg("stop_x"),
+            py::arg("stop_y"),
+            py::arg("stop_z"),
+            py::arg("max_distance")
+        )
+        .def("path_distances",
+            &path_distances,
+            R"del(Returns the walking distance from `start` to each point in `stops`, a list of `(x, y, z)` tuples.
+
+Each distance is `None` if there is no path, or if it is greater than `max_distance`.)del",
+            py::arg("start_x"),
+            py::arg("start_y"),
+            py::arg("start_z"),
+            py::arg("stops"),
+            py::arg("max_distance")
+        )
+        .def("polys_within_path_distance",
+            &polys_within_path_distance,
+            R"del(Returns a list of `(poly, distance, (x, y, z))` tuples for every navmesh poly which can be reached by walking no more than `radius` from `x`, `y`, `z`.  The distance is to the point `(x, y, z)` at which the poly is entered.
+
+The result is meant to be passed to `distances_from_poly_set` to test many positions with a single search.)del",
+            py::arg("x"),
+            py::arg("y"),
+            py::arg("z"),
+            py::arg("radius")
+        )
+        .def("distances_from_poly_set",
+            &distances_from_poly_set,
+            R"del(Returns the walking distance to each `(x, y, z)` tuple in `positions`, using a set returned by `polys_within_path_distance` for `radius`.
+
+The distance is `None` for positions outside of the set, or further than `radius`.)del",
+            py::arg("polys"),
+            py::arg("radius"),
+            py::arg("positions")
         )
         .def("query_heights",
             &python_query_heights,
@@ -208,6 +513,21 @@ This is the value that would be achieved by walking from start to stop.)del",
             py::arg("y2"),
             py::arg("z2")
         )
+        .def("move_along_surface",
+            &move_along_surface,
+            R"del(Moves from `start` toward `stop` along the navmesh, as for a charge, blink or knockback.
+
+Returns a tuple of the farthest point reached, with a precise height, and the normal of the wall which was hit, or `None` if nothing was hit.
+If `slide` is `True`, the movement continues along a wall rather than stopping at it.
+Returns `None` if `start` is not on the navmesh.)del",
+            py::arg("start_x"),
+            py::arg("start_y"),
+            py::arg("start_z"),
+            py::arg("stop_x"),
+            py::arg("stop_y"),
+            py::arg("stop_z"),
+            py::arg("slide") = false
+        )
         .def("find_random_point_around_circle",
             &find_random_point_around_circle,
             "Returns a random point from a circle within or slightly outside of the given radius.",
@@ -216,6 +536,22 @@ This is the value that would be achieved by walking from start to stop.)del",
             py::arg("z"),
             py::arg("radius")
         )
+        .def("find_random_points_around_circle",
+            &find_random_points_around_circle,
+            R"del(Returns a list of up to `count` random points from a circle within or slightly outside of the given radius.
+
+This is cheaper than calling `find_random_point_around_circle` repeatedly.)del",
+            py::arg("x"),
+            py::arg("y"),
+            py::arg("z"),
+            py::arg("radius"),
+            py::arg("count")
+        )
+        .def("seed_random",
+            &pathfind::Map::SeedRandom,
+            "Seeds the generator used by random point queries, making their results reproducible.",
+            py::arg("seed")
+        )
         .def("has_adts",
             &has_adts,
             "Checks if the map has any ADT."
@@ -236,13 +572,88 @@ This is the value that would be achieved by walking from start to stop.)del",
             &los,
             R"del(Checks for line of sight from `start` to `stop`.
 
-If `doodads` is `False` doodads will not be considered during calculations.)del",
+If `doodads` is `False` doodads will not be considered during calculations.
+If `navmesh_first` is `True`, checks between the feet of nearby units are first attempted along the navmesh, which is much cheaper when it succeeds.)del",
             py::arg("start_x"),
             py::arg("start_y"),
             py::arg("start_z"),
             py::arg("stop_x"),
             py::arg("stop_y"),
             py::arg("stop_z"),
-            py::arg("doodads")
+            py::arg("doodads"),
+            py::arg("navmesh_first") = false
+        )
+        .def("set_line_of_sight_cache_capacity",
+            &pathfind::Map::SetLineOfSightCacheCapacity,
+            R"del(Caches up to `capacity` recent `line_of_sight` results, matching endpoints to within a few centimetres.
+
+Entries are discarded when a game object is added near them, and the cache is cleared when an ADT is loaded or unloaded.  Zero, the default, disables the cache.)del",
+            py::arg("capacity")
+        )
+        .def("clear_line_of_sight_cache",
+            &pathfind::Map::ClearLineOfSightCache,
+            "Discards every entry in the line of sight cache."
+        )
+        .def("warm_up_models",
+            &warm_up_models,
+            R"del(Loads the collision models of every instance on a loaded ADT within `radius` of `x`, `y`, `z`.
+
+Models are otherwise loaded by the first query to reach them.  Returns the number of models loaded.)del",
+            py::arg("x"),
+            py::arg("y"),
+            py::arg("z"),
+            py::arg("radius")
+        )
+        .def("build_flow_field",
+            &build_flow_field,
+            R"del(Builds a flow field toward `x`, `y`, `z` which covers every point within `max_cost` of it.
+
+Subsequent calls to `find_path` ending at this target will follow the field rather than searching.
+Returns `False` if the target is not on the navmesh.)del",
+            py::arg("x"),
+            py::arg("y"),
+            py::arg("z"),
+            py::arg("max_cost")
+        )
+        .def("clear_flow_fields",
+            &pathfind::Map::ClearFlowFields,
+            "Drops all flow fields built by `build_flow_field`."
+        )
+        .def("build_path_oracle",
+            &pathfind::Map::BuildPathOracle,
+            R"del(Precomputes the next hop between every pair of polys and saves it alongside the map data.
+
+Only global WMO maps with no more than `max_polys` polys are eligible, otherwise `False` is returned.
+Once built, the table is loaded with the map and `find_path` follows it instead of searching.)del",
+            py::arg("max_polys") = pathfind::PathOracle::DefaultMaxPolys
+        )
+        .def("has_path_oracle",
+            &pathfind::Map::HasPathOracle,
+            "Checks if a path oracle is loaded for the map."
+        )
+        .def("statistics",
+            &statistics,
+            R"del(Returns a dictionary of counters for the queries made against this map.
+
+`direct_paths` counts the `find_path` calls answered by a straight line, with no search.
+`flow_field_hits` counts the `find_path` calls whose corridor was read from a flow field.
+`path_cache_hits` and `path_cache_misses` count the `find_path` calls which consulted the path cache.
+`line_of_sight_cache_hits` and `line_of_sight_cache_misses` do the same for `line_of_sight`.
+`navmesh_line_of_sights` counts the `line_of_sight_queries` answered by the navmesh alone.)del"
+        )
+        .def("set_path_cache_capacity",
+            &pathfind::Map::SetPathCacheCapacity,
+            R"del(Caches the results of up to `capacity` recent path searches, keyed by start and end poly.
+
+Entries are discarded when a tile they cross is unloaded or changed by a game object.  Zero, the default, disables the cache.)del",
+            py::arg("capacity")
+        )
+        .def("clear_path_cache",
+            &pathfind::Map::ClearPathCache,
+            "Discards every entry in the path cache."
+        )
+        .def("reset_statistics",
+            &pathfind::Map::ResetStatistics,
+            "Resets all query counters to zero."
         );
 }
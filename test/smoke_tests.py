@@ -77,6 +77,16 @@ def test_pathfind(temp_dir):
 
 	print("Z value check succeeded")
 
+	# a second warm up of the same area must find every model already loaded
+	map_data.warm_up_models(x, y, expected_z_values[-1], 50.0)
+	if map_data.warm_up_models(x, y, expected_z_values[-1], 50.0) != 0:
+		raise Exception("Warmed up models were loaded twice")
+
+	if pathfind.model_memory_usage() <= 0:
+		raise Exception("Loaded models are not accounted for")
+
+	print("Model warm up check succeeded")
+
 	def compute_path_length(path):
 		result = 0
 		for i in range(1, len(path)):
@@ -98,6 +108,161 @@ def test_pathfind(temp_dir):
 
 	print("Pathfind check succeeded")
 
+	distance = map_data.path_distance(16303.294922, 16789.242188, 45.219631,
+		16200.139648, 16834.345703, 37.028622, 200.0)
+
+	if distance is None or distance < path_length * 0.9 or distance > 200.0:
+		raise Exception("Path distance invalid.  Expected at least {} found {}".format(
+			path_length, distance))
+
+	if map_data.path_distance(16303.294922, 16789.242188, 45.219631,
+		16200.139648, 16834.345703, 37.028622, path_length * 0.5) is not None:
+		raise Exception("Path distance was not bounded")
+
+	distances = map_data.path_distances(16303.294922, 16789.242188, 45.219631,
+		[(16200.139648, 16834.345703, 37.028622)], 200.0)
+
+	if distances[0] is None or not approximate(distances[0], distance, 1.0):
+		raise Exception("Batch path distance invalid.  Expected {} found {}".format(
+			distance, distances[0]))
+
+	print("Path distance check succeeded")
+
+	resampled = map_data.resample_path(path, 2.0)
+
+	if len(resampled) < 5:
+		raise Exception("Resampled path too short: {}".format(len(resampled)))
+
+	for i in range(1, len(resampled)):
+		if math.dist(resampled[i-1], resampled[i]) > 4.0:
+			raise Exception("Resampled points {} and {} too far apart".format(
+				resampled[i-1], resampled[i]))
+
+	print("Resample path check succeeded")
+
+	simplified = map_data.simplify_path(resampled, 0.5)
+
+	if len(simplified) < 2 or len(simplified) >= len(resampled) or \
+		simplified[0] != resampled[0] or simplified[-1] != resampled[-1]:
+		raise Exception("Simplified path invalid.  Length: {} Original: {}".format(
+			len(simplified), len(resampled)))
+
+	# a midpoint on a leg of a straight path may be dropped, which requires a
+	# skip to end exactly on a corner of the path
+	with_midpoints = [path[0]]
+	for i in range(1, len(path)):
+		with_midpoints.append(tuple((a + b) / 2 for a, b in zip(path[i-1], path[i])))
+		with_midpoints.append(path[i])
+
+	simplified = map_data.simplify_path(with_midpoints, 0.5)
+
+	if len(simplified) < 2 or len(simplified) >= len(with_midpoints) or \
+		simplified[0] != with_midpoints[0] or simplified[-1] != with_midpoints[-1]:
+		raise Exception("Simplified straight path invalid.  Length: {} Corners: {}".format(
+			len(simplified), len(path)))
+
+	print("Simplify path check succeeded")
+
+	precise_path = map_data.find_path(16303.294922, 16789.242188, 45.219631,
+		16200.139648, 16834.345703, 37.028622, precise_heights=True)
+
+	if len(precise_path) != len(path):
+		raise Exception("Precise path length {} differs from {}".format(
+			len(precise_path), len(path)))
+
+	for i in range(0, len(path)):
+		if not approximate(precise_path[i][2], path[i][2], 2.0):
+			raise Exception("Precise height {} too far from navmesh height {}".format(
+				precise_path[i][2], path[i][2]))
+
+	corrected = map_data.correct_heights(path)
+
+	if len(corrected) != len(path):
+		raise Exception("Corrected {} heights, expected {}".format(len(corrected), len(path)))
+
+	print("Precise heights check succeeded")
+
+	polys = map_data.polys_within_path_distance(16303.294922, 16789.242188, 45.219631, 200.0)
+	set_distances = map_data.distances_from_poly_set(polys, 200.0,
+		[(16303.294922, 16789.242188, 45.219631), (16200.139648, 16834.345703, 37.028622)])
+
+	if set_distances[0] is None or set_distances[0] > 1.0:
+		raise Exception("Poly set distance to center invalid: {}".format(set_distances[0]))
+
+	if set_distances[1] is None or set_distances[1] > distance:
+		raise Exception("Poly set distance invalid.  Expected at most {} found {}".format(
+			distance, set_distances[1]))
+
+	print("Poly set distance check succeeded")
+
+	map_data.reset_statistics()
+	path = map_data.find_path(16303.294922, 16789.242188, 45.219631,
+		16303.294922 + 2.0, 16789.242188, 45.219631)
+
+	if len(path) != 2 or map_data.statistics()["direct_paths"] != 1:
+		raise Exception("Direct path shortcut was not taken.  Length: {}".format(len(path)))
+
+	print("Direct path check succeeded")
+
+	map_data.set_path_cache_capacity(16)
+	map_data.reset_statistics()
+
+	first = map_data.find_path(16303.294922, 16789.242188, 45.219631,
+		16200.139648, 16834.345703, 37.028622)
+	second = map_data.find_path(16303.294922, 16789.242188, 45.219631,
+		16200.139648, 16834.345703, 37.028622)
+
+	statistics = map_data.statistics()
+	if first != second or statistics["path_cache_hits"] != 1 or statistics["path_cache_misses"] != 1:
+		raise Exception("Path cache invalid.  Hits: {} Misses: {}".format(
+			statistics["path_cache_hits"], statistics["path_cache_misses"]))
+
+	map_data.set_path_cache_capacity(0)
+
+	print("Path cache check succeeded")
+
+	if not map_data.build_flow_field(16200.139648, 16834.345703, 37.028622, 500.0):
+		raise Exception("Failed to build flow field")
+
+	map_data.reset_statistics()
+
+	field_path = map_data.find_path(16303.294922, 16789.242188, 45.219631,
+		16200.139648, 16834.345703, 37.028622)
+	field_path_length = compute_path_length(field_path)
+
+	if len(field_path) < 2 or field_path_length > 100:
+		raise Exception("Flow field path invalid.  Length: {} Distance: {}".format(
+			len(field_path), field_path_length))
+
+	# the path has corners, so only the field can have supplied its corridor
+	statistics = map_data.statistics()
+	if statistics["direct_paths"] != 0 or statistics["flow_field_hits"] != 1:
+		raise Exception("Flow field was not used: {}".format(statistics))
+
+	map_data.clear_flow_fields()
+
+	print("Flow field check succeeded")
+
+	moved = map_data.move_along_surface(16303.294922, 16789.242188, 45.219631,
+		16303.294922 + 2.0, 16789.242188, 45.219631)
+
+	if moved is None or moved[1] is not None or \
+		math.dist(moved[0], (16303.294922 + 2.0, 16789.242188, 45.219631)) > 1.0:
+		raise Exception("Unobstructed move along surface invalid: {}".format(moved))
+
+	moved = map_data.move_along_surface(16303.294922, 16789.242188, 45.219631,
+		16200.139648, 16834.345703, 37.028622)
+
+	if moved is None or \
+		math.dist(moved[0], (16303.294922, 16789.242188, 45.219631)) > \
+		math.dist((16303.294922, 16789.242188, 45.219631), (16200.139648, 16834.345703, 37.028622)) + 1.0:
+		raise Exception("Move along surface invalid: {}".format(moved))
+
+	if moved[1] is not None and not approximate(math.hypot(*moved[1]), 1.0, 0.01):
+		raise Exception("Move along surface hit normal not normalized: {}".format(moved[1]))
+
+	print("Move along surface check succeeded")
+
 	zone, area = map_data.get_zone_and_area(x, y, expected_z_values[-1])
 
 	if zone != 22 or area != 22:
@@ -120,6 +285,51 @@ def test_pathfind(temp_dir):
 
 	print("Should-pass LoS check succeeded")
 
+	map_data.set_line_of_sight_cache_capacity(16)
+	map_data.reset_statistics()
+
+	for i in range(0, 2):
+		if map_data.line_of_sight(16268.3809, 16812.7148, 36.1483,
+			16266.5781 + i * 0.01, 16782.623, 38.5035019, False):
+			raise Exception("Cached should-fail LoS check passed")
+
+	statistics = map_data.statistics()
+	if statistics["line_of_sight_cache_hits"] != 1 or statistics["line_of_sight_cache_misses"] != 1:
+		raise Exception("LoS cache invalid.  Hits: {} Misses: {}".format(
+			statistics["line_of_sight_cache_hits"], statistics["line_of_sight_cache_misses"]))
+
+	# a navmesh-first result must not answer a check which forbids the navmesh
+	map_data.line_of_sight(16268.3809, 16812.7148, 36.1483,
+		16266.5781, 16782.623, 38.5035019, False, navmesh_first=True)
+
+	statistics = map_data.statistics()
+	if statistics["line_of_sight_cache_hits"] != 1 or statistics["line_of_sight_cache_misses"] != 2:
+		raise Exception("Navmesh-first LoS shared a cache entry.  Hits: {} Misses: {}".format(
+			statistics["line_of_sight_cache_hits"], statistics["line_of_sight_cache_misses"]))
+
+	map_data.set_line_of_sight_cache_capacity(0)
+
+	print("LoS cache check succeeded")
+
+	map_data.reset_statistics()
+
+	if map_data.line_of_sight(16268.3809, 16812.7148, 36.1483,
+		16266.5781, 16782.623, 38.5035019, False, navmesh_first=True):
+		raise Exception("Navmesh-first should-fail LoS check passed")
+
+	# consecutive resampled points are two yards apart, at the height of the
+	# navmesh, so nothing but the navmesh is needed to see between them
+	if not map_data.line_of_sight(*resampled[0], *resampled[1], False,
+		navmesh_first=True):
+		raise Exception("Navmesh-first should-pass LoS check failed")
+
+	# only the clear check may be answered by the navmesh alone
+	statistics = map_data.statistics()
+	if statistics["line_of_sight_queries"] != 2 or statistics["navmesh_line_of_sights"] != 1:
+		raise Exception("Navmesh LoS statistics invalid: {}".format(statistics))
+
+	print("Navmesh-first LoS check succeeded")
+
 	radius = 10.0
 	origin = [16303.294922, 16789.242188, 45.219631]
 	should_pass = map_data.find_random_point_around_circle(origin[0], origin[1], origin[2], radius)
@@ -141,6 +351,20 @@ dist: {distance}"
 
 	print("Should-pass find random point around circle succeeded")
 
+	map_data.seed_random(1234)
+	first_points = map_data.find_random_points_around_circle(origin[0], origin[1], origin[2], radius, 16)
+	map_data.seed_random(1234)
+	second_points = map_data.find_random_points_around_circle(origin[0], origin[1], origin[2], radius, 16)
+
+	if len(first_points) == 0 or first_points != second_points:
+		raise Exception("Seeded random points were not reproducible")
+
+	for point in first_points:
+		if math.dist(origin, point) > radius + distance_leeway:
+			raise Exception("Random point {} too far from origin".format(point))
+
+	print("Seeded random points check succeeded")
+
 	should_pass_doodad = map_data.line_of_sight(16275.6895, 16853.9023, 37.8341751,
 		16251.0332, 16858.2988, 34.9305573, False)
 	if should_pass_doodad is False:
@@ -166,6 +390,45 @@ dist: {distance}"
 	if len(path) < 10 or path_length > 60:
 		raise Exception("Path invalid.  Length: {} Distance: {}".format(len(path), path_length))
 
+	if not map_data.build_path_oracle():
+		raise Exception("Failed to build path oracle")
+
+	map_data = pathfind.Map(temp_dir, "bladesedgearena")
+	if not map_data.has_path_oracle():
+		raise Exception("Path oracle was not loaded")
+
+	path = map_data.find_path(6225.82764, 250.215775, 11.2738495, 6216.33350, 234.604645, 4.16993713)
+	path_length = compute_path_length(path)
+
+	if len(path) < 2 or path_length > 60:
+		raise Exception("Oracle path invalid.  Length: {} Distance: {}".format(len(path), path_length))
+
+	print("Path oracle check succeeded")
+
+	# models are shared between maps, so they are only loaded again, this time
+	# quantized, once no map holds them
+	map_data = None
+	pathfind.set_quantize_models(True)
+
+	map_data = pathfind.Map(temp_dir, "development")
+	map_data.load_adt_at(x, y)
+
+	z_values = map_data.query_heights(x, y)
+	z_values.sort()
+
+	pathfind.set_quantize_models(False)
+
+	if len(z_values) != len(expected_z_values):
+		raise Exception("Expected {} quantized Z values, found {}".format(
+			len(expected_z_values), len(z_values)))
+
+	for i in range(0, len(z_values)):
+		if not approximate(expected_z_values[i], z_values[i]):
+			raise Exception("Expected quantized Z {} Found {}".format(
+				expected_z_values[i], z_values[i]))
+
+	print("Quantized model check succeeded")
+
 def main():
 	temp_dir = tempfile.mkdtemp()
 	print("Temporary directory: {}".format(temp_dir))
@@ -1,10 +1,15 @@
 #include "AABBTree.hpp"
 
 #include "BinaryStream.hpp"
+#include "MappedFile.hpp"
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <future>
+#include <limits>
 
 namespace math
 {
@@ -47,60 +52,273 @@ AABBTree::AABBTree(const std::vector<Vertex>& vertices,
     Build(vertices, indices);
 }
 
-BoundingBox AABBTree::GetBoundingBox() const
+BoundingBox AABBTreeView::GetBoundingBox() const
 {
-    if (m_nodes.empty())
+    if (!m_nodeCount)
         return BoundingBox {};
-    return m_nodes.front().bounds;
+    return m_rootBounds;
 }
 
-void AABBTree::Serialize(utility::BinaryStream& stream) const
+std::vector<int> AABBTreeView::GetIndices() const
 {
-    auto const size =
-        sizeof(std::uint32_t) *
-            5 + // magic, Vector3 count, index count, node count, end magic
-        sizeof(Vertex) * m_vertices.size() +      // vertices
-        sizeof(std::int32_t) * m_indices.size() + // indices
-        (sizeof(std::uint8_t) + sizeof(std::uint32_t) + sizeof(BoundingBox)) *
-            m_nodes.size(); // nodes (numFaces + startFace/childen + bounds) *
-                            // count
-
-    auto ourStream = utility::BinaryStream(size);
+    if (m_shortIndexData)
+        return std::vector<int>(m_shortIndexData,
+                                m_shortIndexData + m_indexCount);
 
-    ourStream << StartMagic;
+    return std::vector<int>(m_indexData, m_indexData + m_indexCount);
+}
 
-    ourStream << static_cast<std::uint32_t>(m_vertices.size());
-    ourStream.Write(&m_vertices[0], m_vertices.size() * sizeof(Vector3));
+BoundingBox AABBTreeView::Dequantize(const BoundingBox& parent,
+                                     const QuantizedNode& node)
+{
+    constexpr float step = 1.f / 65535.f;
 
-    ourStream << static_cast<std::uint32_t>(m_indices.size());
+    BoundingBox result;
 
-    for (const auto& index : m_indices)
+    for (auto axis = 0; axis < 3; ++axis)
     {
-        const std::int32_t idx = index;
-        ourStream << idx;
+        auto const min = parent.MinCorner[axis];
+        auto const max = parent.MaxCorner[axis];
+        auto const scale = (max - min) * step;
+
+        // the ends of the range map exactly onto those of the parent, so that
+        // float rounding cannot leave a child poking out of its parent
+        result.MinCorner[axis] = node.min[axis] == 0xFFFF
+                                     ? max
+                                     : min + node.min[axis] * scale;
+        result.MaxCorner[axis] = node.max[axis] == 0xFFFF
+                                     ? max
+                                     : min + node.max[axis] * scale;
     }
 
-    ourStream << static_cast<std::uint32_t>(m_nodes.size());
+    return result;
+}
 
-    for (const auto& node : m_nodes)
+bool AABBTreeView::Bind(const std::uint8_t* data, std::size_t size,
+                        std::size_t& offset)
+{
+    struct Header
     {
-        assert(node.numFaces < 8);
+        std::uint32_t magic;
+        std::uint32_t vertexCount;
+        std::uint32_t indexCount;
+        std::uint32_t nodeCount;
+    };
 
-        ourStream << static_cast<std::uint8_t>(node.numFaces);
+    static_assert(sizeof(Header) == Alignment, "header must keep alignment");
 
-        if (!!node.numFaces)
+    // the arrays are used in place, so they must be aligned in memory and
+    // not merely within the file
+    if (offset + sizeof(Header) > size ||
+        reinterpret_cast<std::uintptr_t>(data + offset) % Alignment != 0)
+        return false;
+
+    Header header;
+    std::memcpy(&header, data + offset, sizeof(header));
+
+    if (header.magic != StartMagicV2)
+        return false;
+
+    auto const nodes = offset + sizeof(Header);
+    auto const vertices = nodes + Align(header.nodeCount * sizeof(Node));
+    auto const indices = vertices + Align(header.vertexCount * sizeof(Vertex));
+    auto const end = indices + Align(header.indexCount * sizeof(int));
+
+    std::uint32_t endMagic;
+    if (end + Alignment > size ||
+        (std::memcpy(&endMagic, data + end, sizeof(endMagic)),
+         endMagic != EndMagic))
+        return false;
+
+    m_nodeData = reinterpret_cast<const Node*>(data + nodes);
+    m_vertexData = reinterpret_cast<const Vertex*>(data + vertices);
+    m_indexData = reinterpret_cast<const int*>(data + indices);
+
+    m_quantizedNodeData = nullptr;
+    m_shortIndexData = nullptr;
+
+    if (header.nodeCount)
+        m_rootBounds = m_nodeData[0].bounds;
+
+    m_nodeCount = header.nodeCount;
+    m_vertexCount = header.vertexCount;
+    m_indexCount = header.indexCount;
+
+    offset = end + Alignment;
+
+    return true;
+}
+
+void AABBTree::BindVectors()
+{
+    auto const quantized = !m_quantizedNodes.empty();
+
+    m_nodeData = quantized ? nullptr : m_nodes.data();
+    m_quantizedNodeData = quantized ? m_quantizedNodes.data() : nullptr;
+    m_vertexData = m_vertices.data();
+    m_indexData = m_shortIndices.empty() ? m_indices.data() : nullptr;
+    m_shortIndexData = m_shortIndices.empty() ? nullptr : m_shortIndices.data();
+
+    m_nodeCount = static_cast<std::uint32_t>(quantized ? m_quantizedNodes.size()
+                                                       : m_nodes.size());
+    m_vertexCount = static_cast<std::uint32_t>(m_vertices.size());
+    m_indexCount = static_cast<std::uint32_t>(
+        m_shortIndices.empty() ? m_indices.size() : m_shortIndices.size());
+
+    // a quantized tree keeps the bounds its nodes are relative to
+    if (!quantized && !m_nodes.empty())
+        m_rootBounds = m_nodes[0].bounds;
+}
+
+void AABBTree::Quantize()
+{
+    if (!m_nodeCount || m_quantizedNodeData)
+        return;
+
+    std::vector<QuantizedNode> nodes(m_nodeCount);
+
+    // each child is quantized against the bounds of its parent as they will
+    // be decoded during traversal, rather than the exact ones, so that error
+    // does not accumulate down the tree
+    std::vector<BoundingBox> decoded(m_nodeCount);
+    decoded[0] = m_nodeData[0].bounds;
+
+    auto const quantize = [](const BoundingBox& parent,
+                             const BoundingBox& child, QuantizedNode& node)
+    {
+        for (auto axis = 0; axis < 3; ++axis)
         {
-            // Write leaf node
-            ourStream << node.startFace << node.bounds;
+            auto const min = parent.MinCorner[axis];
+            auto const extent = parent.MaxCorner[axis] - min;
+
+            if (extent <= 0.f)
+            {
+                node.min[axis] = 0;
+                node.max[axis] = 0xFFFF;
+                continue;
+            }
+
+            auto const lower =
+                std::floor((child.MinCorner[axis] - min) / extent * 65535.f);
+            auto const upper =
+                std::ceil((child.MaxCorner[axis] - min) / extent * 65535.f);
+
+            node.min[axis] = static_cast<std::uint16_t>(
+                (std::max)(0.f, (std::min)(65535.f, lower)));
+            node.max[axis] = static_cast<std::uint16_t>(
+                (std::max)(0.f, (std::min)(65535.f, upper)));
         }
-        else
+
+        // widen any axis which rounding has left short of the exact bounds
+        auto bounds = Dequantize(parent, node);
+
+        for (auto axis = 0; axis < 3; ++axis)
         {
-            // Write inner node
-            ourStream << node.children << node.bounds;
+            while (node.min[axis] > 0 &&
+                   bounds.MinCorner[axis] > child.MinCorner[axis])
+            {
+                --node.min[axis];
+                bounds = Dequantize(parent, node);
+            }
+
+            while (node.max[axis] < 0xFFFF &&
+                   bounds.MaxCorner[axis] < child.MaxCorner[axis])
+            {
+                ++node.max[axis];
+                bounds = Dequantize(parent, node);
+            }
+        }
+
+        return bounds;
+    };
+
+    std::vector<unsigned int> stack {0};
+
+    while (!stack.empty())
+    {
+        auto const index = stack.back();
+        stack.pop_back();
+
+        auto const& node = m_nodeData[index];
+
+        assert(node.numFaces < 8 && node.children <= QuantizedNode::IndexMask);
+
+        nodes[index].data =
+            (node.numFaces << QuantizedNode::IndexBits) | node.children;
+
+        if (index == 0)
+        {
+            // the root is relative to itself
+            for (auto axis = 0; axis < 3; ++axis)
+            {
+                nodes[0].min[axis] = 0;
+                nodes[0].max[axis] = 0xFFFF;
+            }
+        }
+
+        if (!!node.numFaces)
+            continue;
+
+        for (auto child = node.children; child < node.children + 2; ++child)
+        {
+            decoded[child] =
+                quantize(decoded[index], m_nodeData[child].bounds,
+                         nodes[child]);
+            stack.push_back(child);
         }
     }
 
+    // a mapped tree is copied out of the file, which may then be released
+    if (m_vertices.empty())
+        m_vertices.assign(m_vertexData, m_vertexData + m_vertexCount);
+
+    if (m_vertexCount <= 0x10000)
+    {
+        m_shortIndices.assign(m_indexData, m_indexData + m_indexCount);
+        std::vector<int>().swap(m_indices);
+    }
+    else if (m_indices.empty())
+        m_indices.assign(m_indexData, m_indexData + m_indexCount);
+
+    m_rootBounds = decoded[0];
+    m_quantizedNodes = std::move(nodes);
+    std::vector<Node>().swap(m_nodes);
+    m_file.reset();
+
+    BindVectors();
+}
+
+void AABBTree::Serialize(utility::BinaryStream& stream) const
+{
+    // quantization is a load time option, and is not written
+    assert(!m_quantizedNodeData);
+
+    // padding is written from here, and must cover the largest gap
+    static constexpr std::uint8_t padding[Alignment] = {};
+
+    auto const nodesSize = m_nodeCount * sizeof(Node);
+    auto const verticesSize = m_vertexCount * sizeof(Vertex);
+    auto const indicesSize = m_indexCount * sizeof(int);
+
+    auto const size = sizeof(std::uint32_t) * 4 + // magic and counts
+                      Align(nodesSize) + Align(verticesSize) +
+                      Align(indicesSize) + Alignment; // end magic
+
+    auto ourStream = utility::BinaryStream(size);
+
+    ourStream << StartMagicV2 << m_vertexCount << m_indexCount << m_nodeCount;
+
+    ourStream.Write(m_nodeData, nodesSize);
+    ourStream.Write(padding, Align(nodesSize) - nodesSize);
+
+    ourStream.Write(m_vertexData, verticesSize);
+    ourStream.Write(padding, Align(verticesSize) - verticesSize);
+
+    ourStream.Write(m_indexData, indicesSize);
+    ourStream.Write(padding, Align(indicesSize) - indicesSize);
+
     ourStream << EndMagic;
+    ourStream.Write(padding, Alignment - sizeof(EndMagic));
 
     assert(ourStream.wpos() == size);
 
@@ -111,9 +329,41 @@ bool AABBTree::Deserialize(utility::BinaryStream& stream)
 {
     std::uint32_t magic;
     stream >> magic;
-    if (magic != StartMagic)
+    if (magic != StartMagic && magic != StartMagicV2)
         return false;
 
+    m_file.reset();
+    m_quantizedNodes.clear();
+    m_shortIndices.clear();
+
+    if (magic == StartMagicV2)
+    {
+        std::uint32_t vertexCount, indexCount, nodeCount;
+        stream >> vertexCount >> indexCount >> nodeCount;
+
+        m_nodes.resize(nodeCount);
+        m_vertices.resize(vertexCount);
+        m_indices.resize(indexCount);
+
+        auto const read = [&stream](void* dest, std::size_t size)
+        {
+            stream.ReadBytes(dest, size);
+            stream.rpos(stream.rpos() + Align(size) - size);
+        };
+
+        read(m_nodes.data(), nodeCount * sizeof(Node));
+        read(m_vertices.data(), vertexCount * sizeof(Vertex));
+        read(m_indices.data(), indexCount * sizeof(int));
+
+        std::uint32_t endMagic;
+        stream >> endMagic;
+        stream.rpos(stream.rpos() + Alignment - sizeof(endMagic));
+
+        BindVectors();
+
+        return endMagic == EndMagic;
+    }
+
     std::uint32_t vertexCount;
     stream >> vertexCount;
 
@@ -127,6 +377,7 @@ bool AABBTree::Deserialize(utility::BinaryStream& stream)
 
     assert(indexCount > 0);
 
+    m_indices.clear();
     m_indices.reserve(indexCount);
     for (auto i = 0u; i < indexCount; ++i)
     {
@@ -159,6 +410,8 @@ bool AABBTree::Deserialize(utility::BinaryStream& stream)
         }
     }
 
+    BindVectors();
+
     std::uint32_t endMagic;
     stream >> endMagic;
 
@@ -168,6 +421,34 @@ bool AABBTree::Deserialize(utility::BinaryStream& stream)
     return true;
 }
 
+bool AABBTree::Deserialize(std::shared_ptr<const utility::MappedFile> file,
+                           std::size_t& offset)
+{
+    m_nodes.clear();
+    m_vertices.clear();
+    m_indices.clear();
+    m_quantizedNodes.clear();
+    m_shortIndices.clear();
+
+    if (Bind(file->Data(), file->Size(), offset))
+    {
+        m_file = std::move(file);
+        return true;
+    }
+
+    // files written before the version two layout must be copied
+    std::vector<std::uint8_t> buffer(file->Data() + offset,
+                                     file->Data() + file->Size());
+    utility::BinaryStream stream(buffer);
+
+    if (!Deserialize(stream))
+        return false;
+
+    offset += stream.rpos();
+
+    return true;
+}
+
 BoundingBox AABBTree::CalculateFaceBounds(unsigned int* faces,
                                           unsigned int numFaces) const
 {
@@ -203,26 +484,32 @@ void AABBTree::Build(const std::vector<Vertex>& verts,
     m_indices = indices;
 
     m_faceBounds.clear();
+    m_faceCentroids.clear();
     m_faceIndices.clear();
 
-    size_t numFaces = indices.size() / 3;
+    auto const numFaces = static_cast<unsigned int>(indices.size() / 3);
 
     m_faceBounds.reserve(numFaces);
+    m_faceCentroids.reserve(numFaces);
     m_faceIndices.reserve(numFaces);
 
     for (auto i = 0u; i < numFaces; ++i)
     {
         m_faceIndices.push_back(i);
         m_faceBounds.push_back(CalculateFaceBounds(&i, 1));
+        m_faceCentroids.push_back(m_faceBounds.back().getCenter());
     }
 
-    m_freeNode = 1;
-    m_nodes.clear();
-    m_nodes.reserve(int(numFaces * 1.5f));
+    // a tree over n faces has at most 2n - 1 nodes.  each subtree is given a
+    // range of that size up front, so that subtrees may be built in parallel
+    // with no shared allocator.  the unused gaps are removed afterward
+    m_nodes.assign((std::max)(1u, 2 * numFaces) - 1, Node {});
 
-    BuildRecursive(0, m_faceIndices.data(),
-                   static_cast<unsigned int>(numFaces));
-    m_faceBounds.clear();
+    BuildRecursive(0, 1, m_faceIndices.data(), numFaces, 0);
+
+    // the scratch space is no longer needed, and is released
+    std::vector<BoundingBox>().swap(m_faceBounds);
+    std::vector<Vector3>().swap(m_faceCentroids);
 
     // Reorder the model indices according to the face indices
     std::vector<int> sortedIndices(m_indices.size());
@@ -235,7 +522,54 @@ void AABBTree::Build(const std::vector<Vertex>& verts,
     }
 
     m_indices.swap(sortedIndices);
-    m_faceIndices.clear();
+    std::vector<unsigned int>().swap(m_faceIndices);
+
+    // renumber the vertices in the order the sorted faces first use them, so
+    // that the vertices of a leaf lie together in memory.  vertices no face
+    // uses are dropped
+    std::vector<int> order(m_vertices.size(), -1);
+    std::vector<Vertex> vertices;
+    vertices.reserve(m_vertices.size());
+
+    for (auto& index : m_indices)
+    {
+        if (order[index] < 0)
+        {
+            order[index] = static_cast<int>(vertices.size());
+            vertices.push_back(m_vertices[index]);
+        }
+
+        index = order[index];
+    }
+
+    vertices.shrink_to_fit();
+    m_vertices.swap(vertices);
+
+    // lay the nodes out breadth first, keeping the children of each node
+    // adjacent as traversal expects
+    std::vector<Node> nodes;
+    nodes.reserve(m_nodes.size());
+    nodes.push_back(m_nodes[0]);
+
+    for (auto i = 0u; i < nodes.size(); ++i)
+    {
+        if (!!nodes[i].numFaces)
+            continue;
+
+        auto const children = nodes[i].children;
+
+        nodes[i].children = static_cast<std::uint32_t>(nodes.size());
+        nodes.push_back(m_nodes[children + 0]);
+        nodes.push_back(m_nodes[children + 1]);
+    }
+
+    nodes.shrink_to_fit();
+    m_nodes.swap(nodes);
+
+    m_file.reset();
+    m_quantizedNodes.clear();
+    m_shortIndices.clear();
+    BindVectors();
 }
 
 unsigned int AABBTree::GetLongestAxis(const Vector3& v)
@@ -246,83 +580,147 @@ unsigned int AABBTree::GetLongestAxis(const Vector3& v)
     return (v.Y > v.Z) ? 1 : 2;
 }
 
-unsigned int AABBTree::PartitionMedian(Node& node, unsigned int* faces,
-                                       unsigned int numFaces)
+unsigned int AABBTree::PartitionMedian(const BoundingBox& bounds,
+                                       unsigned int* faces,
+                                       unsigned int numFaces) const
 {
-    unsigned int axis = GetLongestAxis(node.bounds.getVector());
+    unsigned int axis = GetLongestAxis(bounds.getVector());
     ModelFaceSorter predicate(m_vertices.data(), m_indices.data(), axis);
 
     std::nth_element(faces, faces + numFaces / 2, faces + numFaces, predicate);
     return numFaces / 2;
 }
 
-unsigned int AABBTree::PartitionSurfaceArea(Node& /*node*/, unsigned int* faces,
-                                            unsigned int numFaces)
+unsigned int AABBTree::PartitionBinned(unsigned int* faces,
+                                       unsigned int numFaces) const
 {
-    unsigned int bestAxis = 0;
-    unsigned int bestIndex = 0;
+    constexpr unsigned int binCount = 32;
 
-    float bestCost = std::numeric_limits<float>::max();
+    float min = std::numeric_limits<float>::lowest();
+    float max = std::numeric_limits<float>::max();
+
+    const BoundingBox empty {{max, max, max}, {min, min, min}};
 
-    for (unsigned int axis = 0; axis < 3; ++axis)
+    // faces are binned by centroid, so the bins span the centroids rather
+    // than the faces themselves
+    auto centroidBounds = empty;
+    for (auto i = 0u; i < numFaces; ++i)
+        centroidBounds.update(m_faceCentroids[faces[i]]);
+
+    struct Bin
     {
-        ModelFaceSorter predicate(m_vertices.data(), m_indices.data(), axis);
-        std::sort(faces, faces + numFaces, predicate);
+        BoundingBox bounds;
+        unsigned int count;
+    };
 
-        // Two passes over data to calculate upper and lower bounds
-        std::vector<float> cumulativeLower(numFaces);
-        std::vector<float> cumulativeUpper(numFaces);
+    auto const binOf = [&](unsigned int face, unsigned int axis, float scale)
+    {
+        auto const offset =
+            m_faceCentroids[face][axis] - centroidBounds.MinCorner[axis];
+        return (std::min)(binCount - 1,
+                          static_cast<unsigned int>(offset * scale));
+    };
 
-        BoundingBox lower, upper;
+    auto bestCost = max;
+    unsigned int bestAxis = 0;
+    unsigned int bestBin = binCount;
 
-        for (unsigned int i = 0; i < numFaces; ++i)
-        {
-            lower.connectWith(m_faceBounds[faces[i]]);
-            upper.connectWith(m_faceBounds[faces[numFaces - i - 1]]);
+    for (auto axis = 0u; axis < 3; ++axis)
+    {
+        auto const extent =
+            centroidBounds.MaxCorner[axis] - centroidBounds.MinCorner[axis];
+
+        if (extent <= 0.f)
+            continue;
 
-            cumulativeLower[i] = lower.getSurfaceArea();
-            cumulativeUpper[numFaces - i - 1] = upper.getSurfaceArea();
+        auto const scale = binCount / extent;
+
+        Bin bins[binCount];
+        for (auto& bin : bins)
+            bin = {empty, 0};
+
+        for (auto i = 0u; i < numFaces; ++i)
+        {
+            auto& bin = bins[binOf(faces[i], axis, scale)];
+            bin.bounds.connectWith(m_faceBounds[faces[i]]);
+            ++bin.count;
         }
 
-        float invTotalArea = 1.0f / cumulativeUpper[0];
+        // cost of everything right of each possible split
+        float rightCost[binCount];
 
-        // Test split positions
-        for (unsigned int i = 0; i < numFaces - 1; ++i)
+        auto bounds = empty;
+        auto count = 0u;
+        for (auto i = binCount - 1; i > 0; --i)
         {
-            float below = cumulativeLower[i] * invTotalArea;
-            float above = cumulativeUpper[i] * invTotalArea;
+            bounds.connectWith(bins[i].bounds);
+            count += bins[i].count;
+            rightCost[i] = count ? bounds.getSurfaceArea() * count : 0.f;
+        }
+
+        bounds = empty;
+        count = 0;
+        for (auto i = 0u; i < binCount - 1; ++i)
+        {
+            bounds.connectWith(bins[i].bounds);
+            count += bins[i].count;
 
-            float cost = 0.125f + (below * i + above * (numFaces - i));
-            if (cost <= bestCost)
+            if (!count || count == numFaces)
+                continue;
+
+            auto const cost =
+                bounds.getSurfaceArea() * count + rightCost[i + 1];
+
+            if (cost < bestCost)
             {
                 bestCost = cost;
-                bestIndex = i;
                 bestAxis = axis;
+                bestBin = i;
             }
         }
     }
 
-    // Sort faces by best axis
-    ModelFaceSorter predicate(m_vertices.data(), m_indices.data(), bestAxis);
-    std::sort(faces, faces + numFaces, predicate);
+    // every centroid is in the same place, so no split is better than any
+    // other
+    if (bestBin == binCount)
+    {
+        BoundingBox bounds = empty;
+        for (auto i = 0u; i < numFaces; ++i)
+            bounds.connectWith(m_faceBounds[faces[i]]);
+
+        return PartitionMedian(bounds, faces, numFaces);
+    }
+
+    auto const scale =
+        binCount / (centroidBounds.MaxCorner[bestAxis] -
+                    centroidBounds.MinCorner[bestAxis]);
+
+    auto const middle = std::partition(
+        faces, faces + numFaces, [&](unsigned int face)
+        { return binOf(face, bestAxis, scale) <= bestBin; });
 
-    return bestIndex + 1;
+    return static_cast<unsigned int>(middle - faces);
 }
 
-void AABBTree::BuildRecursive(unsigned int nodeIndex, unsigned int* faces,
-                              unsigned int numFaces)
+void AABBTree::BuildRecursive(unsigned int nodeIndex, unsigned int firstFree,
+                              unsigned int* faces, unsigned int numFaces,
+                              unsigned int depth)
 {
     const unsigned int maxFacesPerLeaf = 6;
 
-    // Allocate more nodes if out of nodes
-    if (nodeIndex >= m_nodes.size())
-    {
-        int size = std::max(int(1.5f * m_nodes.size()), 512);
-        m_nodes.resize(size);
-    }
+    // beyond this depth there are already enough subtrees being built at
+    // once, and below this many faces one is not worth a thread
+    const unsigned int maxParallelDepth = 3;
+    const unsigned int minParallelFaces = 8192;
 
     auto& node = m_nodes[nodeIndex];
-    node.bounds = CalculateFaceBounds(faces, numFaces);
+
+    float min = std::numeric_limits<float>::lowest();
+    float max = std::numeric_limits<float>::max();
+
+    node.bounds = {{max, max, max}, {min, min, min}};
+    for (auto i = 0u; i < numFaces; ++i)
+        node.bounds.connectWith(m_faceBounds[faces[i]]);
 
     if (numFaces <= maxFacesPerLeaf)
     {
@@ -332,30 +730,50 @@ void AABBTree::BuildRecursive(unsigned int nodeIndex, unsigned int* faces,
                static_cast<std::size_t>(
                    faces - m_faceIndices.data())); // verify no truncation
         node.numFaces = numFaces;
+        return;
     }
-    else
-    {
-        unsigned int leftCount = PartitionSurfaceArea(node, faces, numFaces);
-        unsigned int rightCount = numFaces - leftCount;
 
-        // Allocate 2 nodes
-        node.children = m_freeNode;
-        m_freeNode += 2;
+    unsigned int leftCount = PartitionBinned(faces, numFaces);
+    unsigned int rightCount = numFaces - leftCount;
 
-        // Split faces in half and build each side recursively
-        BuildRecursive(node.children + 0, faces, leftCount);
-        BuildRecursive(node.children + 1, faces + leftCount, rightCount);
+    // the descendants of the left child take the first 2 * leftCount - 2
+    // nodes after the pair, and those of the right child follow
+    node.children = firstFree;
+
+    auto const buildLeft = [=]()
+    {
+        BuildRecursive(firstFree + 0, firstFree + 2, faces, leftCount,
+                       depth + 1);
+    };
+
+    if (depth < maxParallelDepth && numFaces >= minParallelFaces)
+    {
+        auto left = std::async(std::launch::async, buildLeft);
+        BuildRecursive(firstFree + 1, firstFree + 2 * leftCount,
+                       faces + leftCount, rightCount, depth + 1);
+        left.get();
+    }
+    else
+    {
+        buildLeft();
+        BuildRecursive(firstFree + 1, firstFree + 2 * leftCount,
+                       faces + leftCount, rightCount, depth + 1);
     }
 }
 
-bool AABBTree::IntersectRay(Ray& ray, unsigned int* faceIndex) const
+bool AABBTreeView::IntersectRay(Ray& ray, unsigned int* faceIndex) const
 {
     float distance = ray.GetDistance();
-    TraceRecursive(0, ray, faceIndex);
+
+    if (m_quantizedNodeData)
+        TraceQuantized(0, m_rootBounds, ray, faceIndex);
+    else
+        TraceRecursive(0, ray, faceIndex);
+
     return ray.GetDistance() < distance;
 }
 
-void AABBTree::Trace(Ray& ray, unsigned int* faceIndex) const
+void AABBTreeView::Trace(Ray& ray, unsigned int* faceIndex) const
 {
     struct StackEntry
     {
@@ -379,12 +797,12 @@ void AABBTree::Trace(Ray& ray, unsigned int* faceIndex) const
         if (e.dist >= ray.GetDistance())
             continue;
 
-        const Node& node = m_nodes.at(e.node);
+        const Node& node = m_nodeData[e.node];
         if (!node.numFaces)
         {
             // Find closest node
-            auto& leftChild = m_nodes.at(node.children + 0);
-            auto& rightChild = m_nodes.at(node.children + 1);
+            auto& leftChild = m_nodeData[node.children + 0];
+            auto& rightChild = m_nodeData[node.children + 1];
 
             float dist[2] = {max, max};
             ray.IntersectBoundingBox(leftChild.bounds, &dist[0]);
@@ -412,24 +830,32 @@ void AABBTree::Trace(Ray& ray, unsigned int* faceIndex) const
     }
 }
 
-void AABBTree::TraceRecursive(unsigned int nodeIndex, Ray& ray,
+void AABBTreeView::TraceRecursive(unsigned int nodeIndex, Ray& ray,
                               unsigned int* faceIndex) const
 {
-    auto& node = m_nodes.at(nodeIndex);
+    auto& node = m_nodeData[nodeIndex];
     if (!!node.numFaces)
         TraceLeafNode(node, ray, faceIndex);
     else
         TraceInnerNode(node, ray, faceIndex);
 }
 
-void AABBTree::TraceLeafNode(const Node& node, Ray& ray,
-                             unsigned int* faceIndex) const
+void AABBTreeView::TraceLeafNode(const Node& node, Ray& ray,
+                                 unsigned int* faceIndex) const
 {
-    for (auto i = node.startFace; i < node.startFace + node.numFaces; ++i)
+    TraceFaces(m_indexData, node.startFace, node.numFaces, ray, faceIndex);
+}
+
+template <typename Index>
+void AABBTreeView::TraceFaces(const Index* indices, unsigned int startFace,
+                              unsigned int numFaces, Ray& ray,
+                              unsigned int* faceIndex) const
+{
+    for (auto i = startFace; i < startFace + numFaces; ++i)
     {
-        auto& v0 = m_vertices[m_indices[i * 3 + 0]];
-        auto& v1 = m_vertices[m_indices[i * 3 + 1]];
-        auto& v2 = m_vertices[m_indices[i * 3 + 2]];
+        auto& v0 = m_vertexData[indices[i * 3 + 0]];
+        auto& v1 = m_vertexData[indices[i * 3 + 1]];
+        auto& v2 = m_vertexData[indices[i * 3 + 2]];
 
         float distance;
         if (!ray.IntersectTriangle(v0, v1, v2, &distance))
@@ -445,11 +871,55 @@ void AABBTree::TraceLeafNode(const Node& node, Ray& ray,
     }
 }
 
-void AABBTree::TraceInnerNode(const Node& node, Ray& ray,
+void AABBTreeView::TraceQuantized(unsigned int nodeIndex,
+                                  const BoundingBox& bounds, Ray& ray,
+                                  unsigned int* faceIndex) const
+{
+    auto const& node = m_quantizedNodeData[nodeIndex];
+
+    if (!!node.NumFaces())
+    {
+        if (m_shortIndexData)
+            TraceFaces(m_shortIndexData, node.Index(), node.NumFaces(), ray,
+                       faceIndex);
+        else
+            TraceFaces(m_indexData, node.Index(), node.NumFaces(), ray,
+                       faceIndex);
+        return;
+    }
+
+    auto const children = node.Index();
+
+    const BoundingBox childBounds[2] = {
+        Dequantize(bounds, m_quantizedNodeData[children + 0]),
+        Dequantize(bounds, m_quantizedNodeData[children + 1])};
+
+    float max = std::numeric_limits<float>::max();
+    float distance[2] = {max, max};
+
+    ray.IntersectBoundingBox(childBounds[0], &distance[0]);
+    ray.IntersectBoundingBox(childBounds[1], &distance[1]);
+
+    unsigned int closest = 0;
+    unsigned int furthest = 1;
+
+    if (distance[1] < distance[0])
+        std::swap(closest, furthest);
+
+    if (distance[closest] < ray.GetDistance())
+        TraceQuantized(children + closest, childBounds[closest], ray,
+                       faceIndex);
+
+    if (distance[furthest] < ray.GetDistance())
+        TraceQuantized(children + furthest, childBounds[furthest], ray,
+                       faceIndex);
+}
+
+void AABBTreeView::TraceInnerNode(const Node& node, Ray& ray,
                               unsigned int* faceIndex) const
 {
-    auto& leftChild = m_nodes.at(node.children + 0);
-    auto& rightChild = m_nodes.at(node.children + 1);
+    auto& leftChild = m_nodeData[node.children + 0];
+    auto& rightChild = m_nodeData[node.children + 1];
 
     float max = std::numeric_limits<float>::max();
     float distance[2] = {max, max};
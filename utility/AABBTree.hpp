@@ -5,14 +5,24 @@
 #include "Ray.hpp"
 #include "Vector.hpp"
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
+namespace utility
+{
+class MappedFile;
+}
+
 namespace math
 {
-class AABBTree
+// an AABB tree over memory which it does not own.  the node, vertex and
+// index arrays are laid out exactly as in a version two .bvh file, so a tree
+// within a mapped file may be traced in place with nothing copied
+class AABBTreeView
 {
-private:
+protected:
     struct Node
     {
         union
@@ -25,9 +35,100 @@ private:
         BoundingBox bounds;
     };
 
+    // a node whose bounds are stored relative to those of its parent, in
+    // 1/65535ths of the parent's extent on each axis.  the face count shares
+    // the top bits of the child or face index
+    struct QuantizedNode
+    {
+        static constexpr std::uint32_t IndexBits = 29;
+        static constexpr std::uint32_t IndexMask = (1u << IndexBits) - 1;
+
+        std::uint16_t min[3];
+        std::uint16_t max[3];
+        std::uint32_t data;
+
+        std::uint32_t Index() const { return data & IndexMask; }
+        unsigned int NumFaces() const { return data >> IndexBits; }
+    };
+
+    static_assert(sizeof(Node) == 32, "nodes must match the .bvh layout");
+    static_assert(sizeof(QuantizedNode) == 16, "quantized nodes must pack");
+    static_assert(sizeof(Vertex) == 12, "vertices must match the .bvh layout");
+    static_assert(sizeof(int) == 4, "indices must match the .bvh layout");
+
     static constexpr std::uint32_t StartMagic = 'BVH1';
+    static constexpr std::uint32_t StartMagicV2 = 'BVH2';
     static constexpr std::uint32_t EndMagic = 'FOOB';
 
+    // every array of a version two tree begins on this boundary, relative to
+    // the start of the tree
+    static constexpr std::size_t Alignment = 16;
+
+    static constexpr std::size_t Align(std::size_t size)
+    {
+        return (size + Alignment - 1) & ~(Alignment - 1);
+    }
+
+    const Node* m_nodeData = nullptr;
+    const Vertex* m_vertexData = nullptr;
+    const int* m_indexData = nullptr;
+
+    // set in place of the above for a quantized tree.  vertex indices are
+    // stored in 16 bits where they fit
+    const QuantizedNode* m_quantizedNodeData = nullptr;
+    const std::uint16_t* m_shortIndexData = nullptr;
+
+    BoundingBox m_rootBounds;
+
+    std::uint32_t m_nodeCount = 0;
+    std::uint32_t m_vertexCount = 0;
+    std::uint32_t m_indexCount = 0;
+
+public:
+    // points the view at the version two tree found 'offset' bytes into
+    // 'data', and advances 'offset' past it.  returns false if there is no
+    // such tree, or it is not suitably aligned
+    bool Bind(const std::uint8_t* data, std::size_t size, std::size_t& offset);
+
+    bool IntersectRay(Ray& ray, unsigned int* faceIndex = nullptr) const;
+
+    BoundingBox GetBoundingBox() const;
+
+    const Vertex* Vertices() const { return m_vertexData; }
+    std::size_t VertexCount() const { return m_vertexCount; }
+
+    // a copy of the vertex indices, which may not be stored as ints
+    std::vector<int> GetIndices() const;
+    std::size_t IndexCount() const { return m_indexCount; }
+
+protected:
+    // the bounds of a quantized node, given those of its parent.  rounding
+    // never shrinks the result, so traversal remains conservative
+    static BoundingBox Dequantize(const BoundingBox& parent,
+                                  const QuantizedNode& node);
+
+private:
+    void Trace(Ray& ray, unsigned int* faceIndex) const;
+    void TraceRecursive(unsigned int nodeIndex, Ray& ray,
+                        unsigned int* faceIndex) const;
+    void TraceInnerNode(const Node& node, Ray& ray,
+                        unsigned int* faceIndex) const;
+    void TraceLeafNode(const Node& node, Ray& ray,
+                       unsigned int* faceIndex) const;
+
+    void TraceQuantized(unsigned int nodeIndex, const BoundingBox& bounds,
+                        Ray& ray, unsigned int* faceIndex) const;
+
+    template <typename Index>
+    void TraceFaces(const Index* indices, unsigned int startFace,
+                    unsigned int numFaces, Ray& ray,
+                    unsigned int* faceIndex) const;
+};
+
+// an AABB tree which owns its data, either in memory of its own or in the
+// mapped .bvh file from which it was read
+class AABBTree : public AABBTreeView
+{
 public:
     AABBTree() = default;
     AABBTree(AABBTree&& other) = default;
@@ -40,46 +141,75 @@ public:
 public:
     void Build(const std::vector<Vertex>& verts,
                const std::vector<int>& indices);
-    bool IntersectRay(Ray& ray, unsigned int* faceIndex = nullptr) const;
-
-    BoundingBox GetBoundingBox() const;
 
+    // writes the tree in the version two layout
     void Serialize(utility::BinaryStream& stream) const;
+
+    // reads and copies a tree of either version
     bool Deserialize(utility::BinaryStream& stream);
 
-    const std::vector<Vector3>& Vertices() const { return m_vertices; }
-    const std::vector<int>& Indices() const { return m_indices; }
+    // reads the tree found 'offset' bytes into the file, and advances
+    // 'offset' past it.  a version two tree is used in place, and keeps the
+    // file mapped for as long as the tree exists.  a version one tree is
+    // copied
+    bool Deserialize(std::shared_ptr<const utility::MappedFile> file,
+                     std::size_t& offset);
+
+    // replaces the nodes with quantized ones of half the size, and the
+    // vertex indices with 16 bit ones where they fit.  a tree used in place
+    // from a mapped file is copied, and the file released
+    void Quantize();
+
+    // bytes of heap memory held by the tree.  a tree used in place from a
+    // mapped file holds none, as its pages belong to the file cache
+    std::size_t MemoryUsage() const
+    {
+        return m_nodes.capacity() * sizeof(Node) +
+               m_vertices.capacity() * sizeof(Vertex) +
+               m_indices.capacity() * sizeof(int) +
+               m_faceBounds.capacity() * sizeof(BoundingBox) +
+               m_faceCentroids.capacity() * sizeof(Vector3) +
+               m_faceIndices.capacity() * sizeof(unsigned int) +
+               m_quantizedNodes.capacity() * sizeof(QuantizedNode) +
+               m_shortIndices.capacity() * sizeof(std::uint16_t);
+    }
 
 private:
-    unsigned int PartitionMedian(Node& node, unsigned int* faces,
-                                 unsigned int numFaces);
-    unsigned int PartitionSurfaceArea(Node& node, unsigned int* faces,
-                                      unsigned int numFaces);
-
-    void BuildRecursive(unsigned int nodeIndex, unsigned int* faces,
-                        unsigned int numFaces);
+    unsigned int PartitionMedian(const BoundingBox& bounds, unsigned int* faces,
+                                 unsigned int numFaces) const;
+
+    // a surface area heuristic split, estimated over a fixed number of bins
+    // along each axis rather than at every face
+    unsigned int PartitionBinned(unsigned int* faces,
+                                 unsigned int numFaces) const;
+
+    // builds the subtree over the given faces at 'nodeIndex', with its
+    // descendants from 'firstFree'.  large subtrees near the root are built
+    // in parallel
+    void BuildRecursive(unsigned int nodeIndex, unsigned int firstFree,
+                        unsigned int* faces, unsigned int numFaces,
+                        unsigned int depth);
     BoundingBox CalculateFaceBounds(unsigned int* faces,
                                     unsigned int numFaces) const;
 
-    void Trace(Ray& ray, unsigned int* faceIndex) const;
-    void TraceRecursive(unsigned int nodeIndex, Ray& ray,
-                        unsigned int* faceIndex) const;
-    void TraceInnerNode(const Node& node, Ray& ray,
-                        unsigned int* faceIndex) const;
-    void TraceLeafNode(const Node& node, Ray& ray,
-                       unsigned int* faceIndex) const;
-
     static unsigned int GetLongestAxis(const Vector3& v);
 
-private:
-    unsigned int m_freeNode = 0;
+    // points the view at the arrays owned by this tree
+    void BindVectors();
 
+private:
     std::vector<Node> m_nodes;
 
     std::vector<Vertex> m_vertices;
     std::vector<int> m_indices;
 
     std::vector<BoundingBox> m_faceBounds;
+    std::vector<Vector3> m_faceCentroids;
     std::vector<unsigned int> m_faceIndices;
+
+    std::vector<QuantizedNode> m_quantizedNodes;
+    std::vector<std::uint16_t> m_shortIndices;
+
+    std::shared_ptr<const utility::MappedFile> m_file;
 };
 } // namespace math
\ No newline at end of file
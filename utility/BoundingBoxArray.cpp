@@ -0,0 +1,178 @@
+#include "BoundingBoxArray.hpp"
+
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE__) || defined(_M_X64) ||                                     \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define BOUNDING_BOX_ARRAY_SSE
+#endif
+
+namespace math
+{
+void BoundingBoxArray::Clear()
+{
+    m_minX.clear();
+    m_minY.clear();
+    m_minZ.clear();
+    m_maxX.clear();
+    m_maxY.clear();
+    m_maxZ.clear();
+}
+
+void BoundingBoxArray::Reserve(std::size_t count)
+{
+    m_minX.reserve(count);
+    m_minY.reserve(count);
+    m_minZ.reserve(count);
+    m_maxX.reserve(count);
+    m_maxY.reserve(count);
+    m_maxZ.reserve(count);
+}
+
+void BoundingBoxArray::Add(const BoundingBox& box)
+{
+    m_minX.push_back(box.MinCorner.X);
+    m_minY.push_back(box.MinCorner.Y);
+    m_minZ.push_back(box.MinCorner.Z);
+    m_maxX.push_back(box.MaxCorner.X);
+    m_maxY.push_back(box.MaxCorner.Y);
+    m_maxZ.push_back(box.MaxCorner.Z);
+}
+
+void BoundingBoxArray::Intersect(const Ray& ray,
+                                 std::vector<std::uint32_t>& result) const
+{
+    auto const& start = ray.GetStartPoint();
+    auto const direction = ray.GetDirection();
+
+    const Vector3 invDir {1.0f / direction.X, 1.0f / direction.Y,
+                          1.0f / direction.Z};
+
+    // distance along the ray, in the same units as the slab test, beyond
+    // which no closer hit may be found
+    auto const limit = ray.GetLength() * ray.GetDistance();
+
+    auto const count = Size();
+    std::size_t i = 0;
+
+    // the vector min and max instructions return their second operand when
+    // either is NaN, and std::min and std::max return their first.  the
+    // operands are swapped throughout so that rays parallel to an axis are
+    // treated exactly as the scalar test treats them
+
+#if defined(__AVX__)
+    {
+        auto const sx = _mm256_set1_ps(start.X);
+        auto const sy = _mm256_set1_ps(start.Y);
+        auto const sz = _mm256_set1_ps(start.Z);
+        auto const ix = _mm256_set1_ps(invDir.X);
+        auto const iy = _mm256_set1_ps(invDir.Y);
+        auto const iz = _mm256_set1_ps(invDir.Z);
+        auto const zero = _mm256_setzero_ps();
+        auto const max = _mm256_set1_ps(limit);
+
+        auto const slab = [](const float* p, __m256 s, __m256 inv)
+        { return _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(p), s), inv); };
+
+        for (; i + 8 <= count; i += 8)
+        {
+            auto const t1 = slab(&m_minX[i], sx, ix);
+            auto const t2 = slab(&m_maxX[i], sx, ix);
+            auto const t3 = slab(&m_minY[i], sy, iy);
+            auto const t4 = slab(&m_maxY[i], sy, iy);
+            auto const t5 = slab(&m_minZ[i], sz, iz);
+            auto const t6 = slab(&m_maxZ[i], sz, iz);
+
+            auto const tmin = _mm256_max_ps(
+                _mm256_min_ps(t6, t5),
+                _mm256_max_ps(_mm256_min_ps(t4, t3), _mm256_min_ps(t2, t1)));
+            auto const tmax = _mm256_min_ps(
+                _mm256_max_ps(t6, t5),
+                _mm256_min_ps(_mm256_max_ps(t4, t3), _mm256_max_ps(t2, t1)));
+
+            auto const miss = _mm256_or_ps(
+                _mm256_cmp_ps(tmax, zero, _CMP_LT_OQ),
+                _mm256_or_ps(_mm256_cmp_ps(tmin, tmax, _CMP_GT_OQ),
+                             _mm256_cmp_ps(tmin, max, _CMP_GT_OQ)));
+
+            auto const mask = ~_mm256_movemask_ps(miss) & 0xFF;
+
+            for (auto lane = 0u; lane < 8; ++lane)
+                if (!!(mask & (1 << lane)))
+                    result.push_back(static_cast<std::uint32_t>(i + lane));
+        }
+    }
+#endif
+
+#ifdef BOUNDING_BOX_ARRAY_SSE
+    {
+        auto const sx = _mm_set1_ps(start.X);
+        auto const sy = _mm_set1_ps(start.Y);
+        auto const sz = _mm_set1_ps(start.Z);
+        auto const ix = _mm_set1_ps(invDir.X);
+        auto const iy = _mm_set1_ps(invDir.Y);
+        auto const iz = _mm_set1_ps(invDir.Z);
+        auto const zero = _mm_setzero_ps();
+        auto const max = _mm_set1_ps(limit);
+
+        auto const slab = [](const float* p, __m128 s, __m128 inv)
+        { return _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(p), s), inv); };
+
+        for (; i + 4 <= count; i += 4)
+        {
+            auto const t1 = slab(&m_minX[i], sx, ix);
+            auto const t2 = slab(&m_maxX[i], sx, ix);
+            auto const t3 = slab(&m_minY[i], sy, iy);
+            auto const t4 = slab(&m_maxY[i], sy, iy);
+            auto const t5 = slab(&m_minZ[i], sz, iz);
+            auto const t6 = slab(&m_maxZ[i], sz, iz);
+
+            auto const tmin =
+                _mm_max_ps(_mm_min_ps(t6, t5),
+                           _mm_max_ps(_mm_min_ps(t4, t3), _mm_min_ps(t2, t1)));
+            auto const tmax =
+                _mm_min_ps(_mm_max_ps(t6, t5),
+                           _mm_min_ps(_mm_max_ps(t4, t3), _mm_max_ps(t2, t1)));
+
+            auto const miss =
+                _mm_or_ps(_mm_cmplt_ps(tmax, zero),
+                          _mm_or_ps(_mm_cmpgt_ps(tmin, tmax),
+                                    _mm_cmpgt_ps(tmin, max)));
+
+            auto const mask = ~_mm_movemask_ps(miss) & 0xF;
+
+            for (auto lane = 0u; lane < 4; ++lane)
+                if (!!(mask & (1 << lane)))
+                    result.push_back(static_cast<std::uint32_t>(i + lane));
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        auto const t1 = (m_minX[i] - start.X) * invDir.X;
+        auto const t2 = (m_maxX[i] - start.X) * invDir.X;
+        auto const t3 = (m_minY[i] - start.Y) * invDir.Y;
+        auto const t4 = (m_maxY[i] - start.Y) * invDir.Y;
+        auto const t5 = (m_minZ[i] - start.Z) * invDir.Z;
+        auto const t6 = (m_maxZ[i] - start.Z) * invDir.Z;
+
+        auto const tmin = (std::max)((std::max)((std::min)(t1, t2),
+                                                (std::min)(t3, t4)),
+                                     (std::min)(t5, t6));
+        auto const tmax = (std::min)((std::min)((std::max)(t1, t2),
+                                                (std::max)(t3, t4)),
+                                     (std::max)(t5, t6));
+
+        if (tmax < 0 || tmin > tmax || tmin > limit)
+            continue;
+
+        result.push_back(static_cast<std::uint32_t>(i));
+    }
+}
+} // namespace math
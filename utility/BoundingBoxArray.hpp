@@ -0,0 +1,33 @@
+#pragma once
+
+#include "utility/BoundingBox.hpp"
+#include "utility/Ray.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace math
+{
+// a set of bounding boxes, stored as one array per coordinate rather than one
+// box after another, so that a ray may be tested against several at once
+class BoundingBoxArray
+{
+private:
+    std::vector<float> m_minX, m_minY, m_minZ;
+    std::vector<float> m_maxX, m_maxY, m_maxZ;
+
+public:
+    void Clear();
+    void Reserve(std::size_t count);
+    void Add(const BoundingBox& box);
+
+    std::size_t Size() const { return m_minX.size(); }
+
+    // appends to 'result' the index of every box the ray reaches before its
+    // current hit point.  for any one box this is Ray::IntersectBoundingBox(),
+    // with the same floating point results, except that boxes wholly beyond
+    // the hit point are also rejected
+    void Intersect(const Ray& ray, std::vector<std::uint32_t>& result) const;
+};
+} // namespace math
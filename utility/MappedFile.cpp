@@ -0,0 +1,104 @@
+#include "MappedFile.hpp"
+
+#include "Exception.hpp"
+
+#ifndef WIN32
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace utility
+{
+#ifdef WIN32
+MappedFile::MappedFile(const std::filesystem::path& path)
+    : m_data(nullptr), m_size(0), m_file(INVALID_HANDLE_VALUE),
+      m_mapping(nullptr)
+{
+    m_file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                           nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                           nullptr);
+
+    if (m_file == INVALID_HANDLE_VALUE)
+        THROW(Result::FAILED_TO_MAP_FILE);
+
+    LARGE_INTEGER size;
+    if (!::GetFileSizeEx(m_file, &size))
+    {
+        ::CloseHandle(m_file);
+        THROW(Result::FAILED_TO_MAP_FILE);
+    }
+
+    m_size = static_cast<std::size_t>(size.QuadPart);
+
+    // an empty file cannot be mapped, but there is nothing to read anyway
+    if (!m_size)
+        return;
+
+    m_mapping =
+        ::CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (m_mapping)
+        m_data = static_cast<const std::uint8_t*>(
+            ::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+
+    if (!m_data)
+    {
+        if (m_mapping)
+            ::CloseHandle(m_mapping);
+        ::CloseHandle(m_file);
+        THROW(Result::FAILED_TO_MAP_FILE);
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data)
+        ::UnmapViewOfFile(m_data);
+    if (m_mapping)
+        ::CloseHandle(m_mapping);
+    ::CloseHandle(m_file);
+}
+#else
+MappedFile::MappedFile(const std::filesystem::path& path)
+    : m_data(nullptr), m_size(0)
+{
+    auto const file = ::open(path.c_str(), O_RDONLY);
+
+    if (file < 0)
+        THROW(Result::FAILED_TO_MAP_FILE);
+
+    struct stat status;
+    if (::fstat(file, &status) != 0)
+    {
+        ::close(file);
+        THROW(Result::FAILED_TO_MAP_FILE);
+    }
+
+    m_size = static_cast<std::size_t>(status.st_size);
+
+    // an empty file cannot be mapped, but there is nothing to read anyway
+    if (m_size)
+    {
+        auto const data =
+            ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+        if (data != MAP_FAILED)
+            m_data = static_cast<const std::uint8_t*>(data);
+    }
+
+    // the mapping remains valid once the descriptor is closed
+    ::close(file);
+
+    if (m_size && !m_data)
+        THROW(Result::FAILED_TO_MAP_FILE);
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data)
+        ::munmap(const_cast<std::uint8_t*>(m_data), m_size);
+}
+#endif
+} // namespace utility
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <type_traits>
+
+namespace utility
+{
+// a read only view of an entire file, mapped into memory rather than read.
+// pages are only read from disk once they are first touched
+class MappedFile
+{
+private:
+    const std::uint8_t* m_data;
+    std::size_t m_size;
+
+#ifdef WIN32
+    void* m_file;
+    void* m_mapping;
+#endif
+
+public:
+    explicit MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const std::uint8_t* Data() const { return m_data; }
+    std::size_t Size() const { return m_size; }
+
+    // copies a value from the given offset, and advances the offset past it.
+    // returns false if the file ends first
+    template <typename T>
+    bool Read(std::size_t& offset, T& out) const
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "T must be trivially copyable");
+
+        if (offset + sizeof(T) > m_size)
+            return false;
+
+        std::memcpy(&out, m_data + offset, sizeof(T));
+        offset += sizeof(T);
+
+        return true;
+    }
+};
+} // namespace utility
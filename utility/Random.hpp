@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+namespace utility
+{
+// pcg32 (see https://www.pcg-random.org).  small, fast, and deterministic for
+// a given seed, unlike std::random_device
+class Random
+{
+private:
+    static constexpr std::uint64_t Multiplier = 6364136223846793005ull;
+    static constexpr std::uint64_t DefaultStream = 0xda3e39cb94b95bdbull;
+
+    std::uint64_t m_state;
+    std::uint64_t m_increment;
+
+public:
+    explicit Random(std::uint64_t seed = 0x853c49e6748fea9bull) { Seed(seed); }
+
+    void Seed(std::uint64_t seed, std::uint64_t stream = DefaultStream)
+    {
+        m_state = 0;
+        m_increment = (stream << 1u) | 1u;
+        Next();
+        m_state += seed;
+        Next();
+    }
+
+    std::uint32_t Next()
+    {
+        auto const old = m_state;
+        m_state = old * Multiplier + m_increment;
+
+        auto const xorShifted =
+            static_cast<std::uint32_t>(((old >> 18u) ^ old) >> 27u);
+        auto const rotation = static_cast<std::uint32_t>(old >> 59u);
+
+        return (xorShifted >> rotation) | (xorShifted << ((~rotation + 1) & 31));
+    }
+
+    // uniformly distributed in [0, 1)
+    float NextFloat()
+    {
+        // the top 24 bits are exactly representable in a float mantissa
+        return static_cast<float>(Next() >> 8) * (1.f / 16777216.f);
+    }
+};
+} // namespace utility
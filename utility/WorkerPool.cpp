@@ -0,0 +1,60 @@
+#include "WorkerPool.hpp"
+
+#include <utility>
+
+namespace utility
+{
+WorkerPool::WorkerPool(std::size_t threads) : m_shutdown(false)
+{
+    m_threads.reserve(threads);
+
+    for (auto i = 0u; i < threads; ++i)
+        m_threads.emplace_back(&WorkerPool::Work, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_shutdown = true;
+        m_jobs.clear();
+    }
+
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+void WorkerPool::Submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_jobs.push_back(std::move(job));
+    }
+
+    m_wake.notify_one();
+}
+
+void WorkerPool::Work()
+{
+    for (;;)
+    {
+        std::function<void()> job;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock,
+                        [this]() { return m_shutdown || !m_jobs.empty(); });
+
+            if (m_shutdown)
+                return;
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        job();
+    }
+}
+} // namespace utility
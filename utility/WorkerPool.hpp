@@ -0,0 +1,37 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utility
+{
+// a fixed set of threads which run submitted jobs in the order received
+class WorkerPool
+{
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::function<void()>> m_jobs;
+    bool m_shutdown;
+
+    std::vector<std::thread> m_threads;
+
+    void Work();
+
+public:
+    explicit WorkerPool(std::size_t threads);
+
+    // jobs not yet started are discarded.  those running are waited for
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void Submit(std::function<void()> job);
+};
+} // namespace utility